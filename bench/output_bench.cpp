@@ -0,0 +1,125 @@
+// Microbenchmark: formatting Tessa output with iostreams (the way output_edge
+// used to do it) versus with Output_writer. Also checks that both produce
+// exactly the same bytes.
+//
+// Usage: tessa_output_bench [number of vertices]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/output_writer.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Vertex { int id; double x, y; };
+struct Edge { int a, b; double distance; int type; };
+
+std::string type_name(int type) {
+    switch(type) {
+    case 0: return "boundary";
+    case 1: return "hole";
+    case 2: return "road";
+    case 3: return "mesh";
+    default: return "unknown";
+    }
+}
+
+// The old path: one operator<< per field, strings built per edge
+void write_iostream( std::ostream &out, const std::vector<Vertex> &vertices, const std::vector<Edge> &edges, std::string free_for ) {
+    out << std::fixed << std::setprecision(7);
+    out << vertices.size() << "\n";
+    out << edges.size() << "\n";
+    for( auto &v : vertices ) {
+        out << v.id << ";" << v.x << ";" << v.y << "\n";
+    }
+    for( auto &e : edges ) {
+        std::string ff = free_for; // output_edge took it by value
+        std::string bidirectional = "1";
+        out << e.a << ";";
+        out << e.b << ";";
+        out << e.distance << ";";
+        out << ff << ";";
+        out << bidirectional << ";";
+        out << type_name(e.type) << ";\n";
+    }
+}
+
+std::string_view type_name_view(int type) {
+    switch(type) {
+    case 0: return "boundary";
+    case 1: return "hole";
+    case 2: return "road";
+    case 3: return "mesh";
+    default: return "unknown";
+    }
+}
+
+void write_buffered( Output_writer &out, const std::vector<Vertex> &vertices, const std::vector<Edge> &edges, const std::string &free_for ) {
+    out.put( vertices.size() );
+    out.put( '\n' );
+    out.put( edges.size() );
+    out.put( '\n' );
+    for( auto &v : vertices ) {
+        out.put( v.id );
+        out.put( ';' );
+        out.put_fixed( v.x );
+        out.put( ';' );
+        out.put_fixed( v.y );
+        out.put( '\n' );
+    }
+    for( auto &e : edges ) {
+        out.put( e.a );
+        out.put( ';' );
+        out.put( e.b );
+        out.put( ';' );
+        out.put_fixed( e.distance );
+        out.put( ';' );
+        out.put( free_for );
+        out.put( ';' );
+        out.put( "1" );
+        out.put( ';' );
+        out.put( type_name_view(e.type) );
+        out.put( ";\n" );
+    }
+}
+
+int main( int argc, char **argv ) {
+    int n = argc>1 ? std::atoi(argv[1]) : 1000000;
+
+    // UTM-like coordinates, and roughly three edges per vertex like a triangulation
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> xs(5e5, 5.1e5), ys(5.27e6, 5.28e6), len(0, 400);
+    std::uniform_int_distribution<int> ids(0, n-1), types(0, 3);
+    std::vector<Vertex> vertices(n);
+    for( int i=0; i<n; ++i ) vertices[i] = { i, xs(rng), ys(rng) };
+    std::vector<Edge> edges(3*static_cast<size_t>(n));
+    for( auto &e : edges ) e = { ids(rng), ids(rng), len(rng), types(rng) };
+    std::string free_for = "car";
+
+    auto t0 = Clock::now();
+    std::ostringstream ss;
+    write_iostream( ss, vertices, edges, free_for );
+    std::string reference = ss.str();
+    auto t1 = Clock::now();
+    Output_writer out;
+    write_buffered( out, vertices, edges, free_for );
+    auto t2 = Clock::now();
+
+    double ms_iostream = std::chrono::duration<double,std::milli>(t1-t0).count();
+    double ms_buffered = std::chrono::duration<double,std::milli>(t2-t1).count();
+    double mb = reference.size()/1e6;
+    std::cout << "vertices: " << n << ", edges: " << edges.size() << ", output: " << mb << " MB\n";
+    std::cout << "iostream: " << ms_iostream << " ms (" << mb/(ms_iostream/1000) << " MB/s)\n";
+    std::cout << "buffered: " << ms_buffered << " ms (" << mb/(ms_buffered/1000) << " MB/s)\n";
+    if( out.str()!=reference ) {
+        std::cout << "MISMATCH: outputs differ!\n";
+        return 1;
+    }
+    std::cout << "outputs are identical\n";
+}
@@ -0,0 +1,104 @@
+// Benchmark: parse throughput of the Spirit WKT grammar versus the
+// hand-written parser, on generated inputs of increasing size.
+// Also reports whether both parsers read the same coordinates.
+//
+// Usage: tessa_parse_bench [largest number of vertices]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "../src/logging.h"
+#include "../src/parse_wkt.h"
+
+using Clock = std::chrono::steady_clock;
+
+const double pi = 3.14159265358979323846;
+
+// A star-shaped ring around a UTM-like centre, with a few holes and roads,
+// printed with as many digits as our exporters use.
+std::string generate_wkt( int n, std::mt19937_64 &rng ) {
+    std::uniform_real_distribution<double> wobble(0.8, 1.0);
+    const double cx = 514850, cy = 5279470, r = 1000;
+    char buf[64];
+    std::string wkt = "GEOMETRYCOLLECTION(POLYGON((";
+    auto point = [&]( double x, double y, bool last ) {
+        std::snprintf(buf, sizeof(buf), "%.10f %.9f%s", x, y, last ? "" : ",\n");
+        wkt += buf;
+    };
+    for( int i=0; i<n; ++i ) {
+        double a = 2*pi*i/n, f = wobble(rng);
+        point( cx+r*f*std::cos(a), cy+r*f*std::sin(a), false );
+    }
+    point( cx+r, cy, true ); // not quite closed, doesn't matter for parsing
+    wkt += ")";
+    for( int h=0; h<4; ++h ) {
+        wkt += ",(";
+        double hx = cx + (h%2 ? 200 : -200), hy = cy + (h/2 ? 200 : -200);
+        for( int i=0; i<=n/100; ++i ) {
+            double a = 2*pi*i/(n/100+1);
+            point( hx+50*std::cos(a), hy+50*std::sin(a), i==n/100 );
+        }
+        wkt += ")";
+    }
+    wkt += "),MULTILINESTRING(";
+    for( int l=0; l<10; ++l ) {
+        wkt += l ? ",(" : "(";
+        for( int i=0; i<=n/20; ++i ) {
+            point( cx-700+1400.0*i/(n/20+1), cy-450+100*l, i==n/20 );
+        }
+        wkt += ")";
+    }
+    wkt += "))";
+    return wkt;
+}
+
+// number of coordinates that differ between the two parses
+long count_differences( const parser::TessaInput &a, const parser::TessaInput &b ) {
+    long diff = 0;
+    auto compare = [&]( const std::vector<parser::Points> &as, const std::vector<parser::Points> &bs ) {
+        if( as.size()!=bs.size() ) { diff += 1000000; return; }
+        for( std::size_t i=0; i<as.size(); ++i ) {
+            if( as[i].size()!=bs[i].size() ) { diff += 1000000; continue; }
+            for( std::size_t j=0; j<as[i].size(); ++j ) {
+                diff += (as[i][j].x!=bs[i][j].x) + (as[i][j].y!=bs[i][j].y);
+            }
+        }
+    };
+    if( a.polygons.size()!=b.polygons.size() ) return 1000000;
+    for( std::size_t i=0; i<a.polygons.size(); ++i ) compare( a.polygons[i], b.polygons[i] );
+    compare( a.linestrings, b.linestrings );
+    return diff;
+}
+
+int main( int argc, char **argv ) {
+    console = spdlog::stderr_color_mt("console");
+    int largest = argc>1 ? std::atoi(argv[1]) : 1000000;
+    std::mt19937_64 rng(42);
+
+    std::printf( "%10s %10s %14s %14s %10s %12s\n", "vertices", "MB", "spirit MB/s", "fast MB/s", "speedup", "differences" );
+    for( int n=1000; n<=largest; n*=10 ) {
+        std::string wkt = generate_wkt(n, rng);
+        double mb = wkt.size()/1e6;
+
+        auto t0 = Clock::now();
+        auto [spirit_ok, spirit_input] = parser::parse_wkt_spirit(wkt);
+        auto t1 = Clock::now();
+        parser::TessaInput fast_input;
+        bool fast_ok = parser::parse_wkt_fast(wkt, fast_input);
+        auto t2 = Clock::now();
+        if( !spirit_ok || !fast_ok ) {
+            std::printf( "parse failed (spirit %d, fast %d)\n", spirit_ok, fast_ok );
+            return 1;
+        }
+
+        double s_spirit = std::chrono::duration<double>(t1-t0).count();
+        double s_fast = std::chrono::duration<double>(t2-t1).count();
+        std::printf( "%10d %10.2f %14.1f %14.1f %10.1f %12ld\n", n, mb, mb/s_spirit, mb/s_fast, s_spirit/s_fast,
+                     count_differences(spirit_input, fast_input) );
+    }
+}
@@ -0,0 +1,157 @@
+#ifndef INCLUDED_POLYGON_GENERATOR
+#define INCLUDED_POLYGON_GENERATOR
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "../src/tessa_input.h"
+
+// === Synthetic inputs for benchmarks ===
+// A star-shaped outer ring around (offset_x, offset_y), holes on a grid in
+// the middle, and roads along the grid lines between the rows of holes. No
+// two chains cross or touch, so every kernel and mode can take the result.
+// With degenerate>0, that fraction of the segments gets an extra point:
+// either almost on the segment (nearly collinear) or very close to one of
+// its ends (a very short edge).
+
+struct Generator_params {
+    std::size_t ring_vertices = 1000;
+    std::size_t holes = 0;
+    std::size_t hole_vertices = 32;
+    std::size_t roads = 0;
+    std::size_t road_vertices = 64;   // density of the roads
+    double degenerate = 0;
+    double radius = 1000;             // metres
+    double offset_x = 5e5, offset_y = 5e6; // UTM-like magnitudes
+    unsigned seed = 1;
+};
+
+// Parameters for about n vertices in total: 40% outer ring, 30% holes, 30% roads
+inline Generator_params params_for_size( std::size_t n, double degenerate = 0.01 ) {
+    Generator_params params;
+    params.ring_vertices = std::max<std::size_t>( 8, 4*n/10 );
+    params.holes = 3*n/10/params.hole_vertices;
+    params.roads = 3*n/10/params.road_vertices;
+    params.degenerate = degenerate;
+    return params;
+}
+
+inline parser::TessaInput generate_polygon( const Generator_params &params ) {
+    const double pi = 3.14159265358979323846;
+    std::mt19937_64 rng(params.seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    const double R = params.radius, cx = params.offset_x, cy = params.offset_y;
+
+    // Add the near-degenerate points to a chain
+    auto degenerate = [&]( parser::Points &chain ) {
+        if( params.degenerate<=0 ) return;
+        parser::Points out;
+        out.reserve( chain.size()*(1+params.degenerate)+1 );
+        for( std::size_t i=0; i+1<chain.size(); ++i ) {
+            parser::Point p = chain[i], q = chain[i+1];
+            out.push_back(p);
+            if( uniform(rng)>=params.degenerate ) continue;
+            double dx = q.x-p.x, dy = q.y-p.y;
+            if( uniform(rng)<0.5 ) {
+                double t = 0.5, off = 1e-9*R/std::max(1e-300, std::hypot(dx,dy));
+                out.push_back({ p.x+t*dx-off*dy, p.y+t*dy+off*dx });
+            } else {
+                out.push_back({ p.x+1e-7*dx, p.y+1e-7*dy });
+            }
+        }
+        out.push_back(chain.back());
+        chain.swap(out);
+    };
+
+    parser::TessaInput input;
+    input.polygons.resize(1);
+    parser::Polygon &polygon = input.polygons[0];
+
+    // Outer ring: increasing angles, so any radii give a simple ring; all
+    // radii are at least 0.7R, outside the square the holes and roads use.
+    // The noise shrinks with the spacing of the points, so the ring does not
+    // get needle-like spikes that the degenerate points could cross.
+    std::size_t n = std::max<std::size_t>(3, params.ring_vertices);
+    parser::Points ring;
+    double phase = 2*pi*uniform(rng), noise = 0.05*std::min(1.0, 100.0/n);
+    for( std::size_t i=0; i<n; ++i ) {
+        double a = 2*pi*(i+0.5*uniform(rng))/n;
+        double r = R*( 0.85 + 0.1*std::sin(7*a+phase) + noise*uniform(rng) );
+        ring.push_back({ cx+r*std::cos(a), cy+r*std::sin(a) });
+    }
+    ring.push_back(ring.front());
+    degenerate(ring);
+    polygon.push_back(std::move(ring));
+
+    // Holes at the centres of a g by g grid on [-s,s]^2; radius at most a
+    // quarter of a cell, so at least a quarter cell from every grid line
+    const double s = 0.45*R;
+    std::size_t g = std::max<std::size_t>( 1, static_cast<std::size_t>(std::ceil(std::sqrt(double(params.holes)))) );
+    double cell = 2*s/g;
+    std::size_t m = std::max<std::size_t>(3, params.hole_vertices);
+    for( std::size_t h=0; h<params.holes; ++h ) {
+        double hx = cx - s + (h%g+0.5)*cell, hy = cy - s + (h/g+0.5)*cell;
+        double hr = 0.25*cell*(0.5+0.5*uniform(rng));
+        parser::Points hole;
+        for( std::size_t i=0; i<m; ++i ) {
+            double a = 2*pi*(i+0.5*uniform(rng))/m;
+            hole.push_back({ hx+hr*std::cos(a), hy+hr*std::sin(a) });
+        }
+        hole.push_back(hole.front());
+        degenerate(hole);
+        polygon.push_back(std::move(hole));
+    }
+
+    // Roads on the g+1 horizontal grid lines, each line cut into pieces,
+    // wiggling less than an eighth of a cell
+    std::size_t lines = g+1;
+    std::size_t pieces = std::max<std::size_t>( 1, (params.roads+lines-1)/lines );
+    double piece = 2*s/pieces;
+    std::size_t k = std::max<std::size_t>(2, params.road_vertices);
+    for( std::size_t l=0; l<params.roads; ++l ) {
+        double y = cy - s + (l%lines)*cell;
+        double x0 = cx - s + (l/lines)*piece, x1 = x0 + 0.9*piece;
+        parser::Points road;
+        for( std::size_t i=0; i<k; ++i ) {
+            road.push_back({ x0+(x1-x0)*i/(k-1), y+0.125*cell*(uniform(rng)-0.5) });
+        }
+        degenerate(road);
+        input.linestrings.push_back(std::move(road));
+    }
+    return input;
+}
+
+// The input as WKT, with enough digits to read back the same doubles
+inline std::string to_wkt( const parser::TessaInput &input ) {
+    std::string wkt = "GEOMETRYCOLLECTION(POLYGON(";
+    char buf[64];
+    auto chain = [&]( const parser::Points &points ) {
+        wkt += '(';
+        for( std::size_t i=0; i<points.size(); ++i ) {
+            std::snprintf( buf, sizeof(buf), "%s%.17g %.17g", i ? "," : "", points[i].x, points[i].y );
+            wkt += buf;
+        }
+        wkt += ')';
+    };
+    for( std::size_t r=0; r<input.polygons[0].size(); ++r ) {
+        if( r ) wkt += ',';
+        chain( input.polygons[0][r] );
+    }
+    wkt += ")";
+    if( !input.linestrings.empty() ) {
+        wkt += ",MULTILINESTRING(";
+        for( std::size_t l=0; l<input.linestrings.size(); ++l ) {
+            if( l ) wkt += ',';
+            chain( input.linestrings[l] );
+        }
+        wkt += ")";
+    }
+    wkt += ")";
+    return wkt;
+}
+
+#endif //ndef INCLUDED_POLYGON_GENERATOR
\ No newline at end of file
@@ -0,0 +1,116 @@
+// Load generator: latency of `tessa --serve` versus starting tessa once per
+// request, on the same input and options. Reports p50 and p99 over all requests.
+// POSIX only.
+//
+// Usage: tessa_serve_load <tessa executable> <input file> [requests] [tessa options...]
+// e.g.   tessa_serve_load bin/tessa polygon.wkt 500 --mesh --B 0.1
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "../src/logging.h"
+#include "../src/serve.h"
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds( Clock::duration d ) {
+    return std::chrono::duration<double,std::milli>(d).count();
+}
+
+void report( const char *name, std::vector<double> ms ) {
+    std::sort(ms.begin(), ms.end());
+    auto percentile = [&]( double p ) { return ms[std::min(ms.size()-1, static_cast<std::size_t>(p*ms.size()))]; };
+    double total = 0;
+    for( double m : ms ) total += m;
+    std::printf( "%-10s %8zu %10.3f %10.3f %10.3f %10.3f\n", name, ms.size(), percentile(0.5), percentile(0.99), ms.back(), total/ms.size() );
+}
+
+// fork and exec argv; stdin and stdout become the given descriptors (or stay if -1)
+pid_t spawn( std::vector<std::string> args, int in, int out ) {
+    pid_t pid = fork();
+    if( pid==0 ) {
+        if( in>=0 ) dup2(in, 0);
+        if( out>=0 ) dup2(out, 1);
+        std::vector<char*> argv;
+        for( auto &a : args ) argv.push_back(&a[0]);
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        std::perror("execv");
+        std::_Exit(127);
+    }
+    return pid;
+}
+
+int main( int argc, char **argv ) {
+    console = spdlog::stderr_color_mt("console");
+    if( argc<3 ) {
+        std::fprintf( stderr, "Usage: %s <tessa executable> <input file> [requests] [tessa options...]\n", argv[0] );
+        return 1;
+    }
+    std::string tessa = argv[1], input_file = argv[2];
+    int requests = argc>3 ? std::atoi(argv[3]) : 200;
+    std::vector<std::string> options( argv+std::min(argc,4), argv+argc );
+    std::ifstream in(input_file, std::ios::binary);
+    std::string input( std::istreambuf_iterator<char>(in), {} );
+
+    std::printf( "%-10s %8s %10s %10s %10s %10s\n", "mode", "requests", "p50 ms", "p99 ms", "max ms", "mean ms" );
+
+    // One process per request
+    std::vector<double> one_shot;
+    for( int r=0; r<requests; ++r ) {
+        std::vector<std::string> args{ tessa, "-f", input_file, "-o", "/dev/null" };
+        args.insert( args.end(), options.begin(), options.end() );
+        auto t0 = Clock::now();
+        pid_t pid = spawn(args, -1, -1);
+        int status;
+        waitpid(pid, &status, 0);
+        one_shot.push_back( milliseconds(Clock::now()-t0) );
+        if( !WIFEXITED(status) || WEXITSTATUS(status)!=0 ) {
+            std::fprintf( stderr, "tessa failed\n" );
+            return 1;
+        }
+    }
+    report( "one-shot", one_shot );
+
+    // One server, talking over pipes
+    int to_server[2], from_server[2];
+    if( pipe(to_server)<0 || pipe(from_server)<0 ) {
+        std::perror("pipe");
+        return 1;
+    }
+    pid_t server = spawn( { tessa, "--serve" }, to_server[0], from_server[1] );
+    close(to_server[0]);
+    close(from_server[1]);
+    std::string request;
+    for( auto &o : options ) request += o + ' ';
+    request += '\n';
+    request += input;
+    serve::Frame_reader reader(from_server[0]);
+    std::string response;
+    std::vector<double> served;
+    for( int r=0; r<requests; ++r ) {
+        auto t0 = Clock::now();
+        if( !serve::write_frame(to_server[1], request) || !reader.read_frame(response) ) {
+            std::fprintf( stderr, "server went away\n" );
+            return 1;
+        }
+        served.push_back( milliseconds(Clock::now()-t0) );
+        if( response.compare(0, 3, "ok\n")!=0 ) {
+            std::fprintf( stderr, "request failed\n" );
+            return 1;
+        }
+    }
+    close(to_server[1]);
+    waitpid(server, nullptr, 0);
+    report( "serve", served );
+}
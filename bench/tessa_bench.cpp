@@ -0,0 +1,137 @@
+// Benchmark suite: every mode on generated inputs from 1e2 to 1e6 vertices,
+// with the time per stage (see src/stats.h) and the scaling exponent of the
+// total time between sizes (1 is linear, 2 quadratic). Then the effect of
+// coordinate magnitude and of near-degenerate features at a fixed size.
+//
+// Usage: tessa_bench [largest number of vertices] [epeck|epick]
+//        tessa_bench --wkt <vertices> [degenerate fraction] > polygon.wkt
+// The second form writes one generated input, to feed to tessa itself.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <tuple>
+
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "../src/logging.h"
+#include "../src/parse_wkt.h"
+#include "../src/tessa.h"
+#include "../src/write_mesh.h"
+#include "polygon_generator.h"
+
+struct Mode {
+    const char *name;
+    bool cdt, mesh, gabriel;
+    double B, S; // S relative to the radius of the input
+};
+
+const Mode modes[] = {
+    { "cdt",            true,  false, false, 0.125, 0 },
+    { "mesh",           false, true,  false, 0.125, 0 },
+    { "mesh-B0.2",      false, true,  false, 0.2,   0 },
+    { "mesh-S0.05",     false, true,  false, 0.125, 0.05 },
+    { "gabriel",        false, false, true,  0.125, 0 },
+};
+
+// Parse, tessellate and write one input; times per stage in stats
+bool run( const parser::TessaInput &generated, const Mode &mode, const std::string &kernel, double radius, Tessa_stats &stats ) {
+    std::string wkt = to_wkt(generated);
+    Tessa_options options;
+    options.make_cdt = mode.cdt;
+    options.make_mesh = mode.mesh;
+    options.make_gabriel = mode.gabriel;
+    options.meshing_param_B = mode.B;
+    options.meshing_param_S = mode.S*radius;
+    options.kernel = kernel;
+
+    parser::TessaInput input;
+    {
+        Stage_timer timer(stats.parse_ms);
+        bool ok;
+        std::tie(ok, input) = parser::parse_wkt_polygon(wkt);
+        if( !ok ) return false;
+    }
+    Tessa_mesh mesh;
+    try {
+        tessellate(input, options, mesh, &stats);
+    } catch( std::exception &x ) {
+        std::fprintf( stderr, "%s failed: %s\n", mode.name, x.what() );
+        return false;
+    }
+    Stage_timer timer(stats.output_ms);
+    Output_writer out( nullptr );
+    write_text(out, mesh, options.free_for);
+    return !out.take_str().empty();
+}
+
+double total_ms( const Tessa_stats &s ) {
+    return s.parse_ms + s.insert_vertices_ms + s.insert_chain_ms + s.refine_ms + s.domain_marking_ms
+         + s.label_repair_ms + s.id_cleanup_ms + s.collect_ms + s.output_ms;
+}
+
+void print_header( const char *first ) {
+    std::printf( "%-12s %9s %9s %9s | %8s %8s %8s %9s %8s %8s %8s %8s %8s | %9s %6s\n",
+                 first, "n", "in", "out", "parse", "ins_v", "ins_c", "refine", "mark", "label", "ids", "collect", "output", "total", "exp" );
+}
+
+void print_row( const char *name, std::size_t n, const Tessa_stats &s, double exponent ) {
+    std::printf( "%-12s %9zu %9zu %9zu | %8.1f %8.1f %8.1f %9.1f %8.1f %8.1f %8.1f %8.1f %8.1f | %9.1f ",
+                 name, n, s.input_vertices, s.output_vertices, s.parse_ms, s.insert_vertices_ms, s.insert_chain_ms,
+                 s.refine_ms, s.domain_marking_ms, s.label_repair_ms, s.id_cleanup_ms, s.collect_ms, s.output_ms, total_ms(s) );
+    if( std::isnan(exponent) ) std::printf( "%6s\n", "-" );
+    else std::printf( "%6.2f\n", exponent );
+    std::fflush(stdout);
+}
+
+int main( int argc, char **argv ) {
+    console = spdlog::stderr_color_mt("console");
+    console->set_level(spdlog::level::err);
+
+    if( argc>2 && std::strcmp(argv[1], "--wkt")==0 ) {
+        Generator_params params = params_for_size( std::atol(argv[2]), argc>3 ? std::atof(argv[3]) : 0.01 );
+        std::printf( "%s\n", to_wkt(generate_polygon(params)).c_str() );
+        return 0;
+    }
+    std::size_t largest = argc>1 ? std::atol(argv[1]) : 1000000;
+    std::string kernel = argc>2 ? argv[2] : "epeck";
+    std::printf( "Kernel %s; times in ms; exp is the scaling exponent of the total time\n\n", kernel.c_str() );
+
+    // Scaling: every mode at every size
+    print_header("mode");
+    for( const Mode &mode : modes ) {
+        double previous_n = 0, previous_ms = 0;
+        for( std::size_t n=100; n<=largest; n*=10 ) {
+            Generator_params params = params_for_size(n);
+            Tessa_stats stats;
+            if( !run(generate_polygon(params), mode, kernel, params.radius, stats) ) return 1;
+            double ms = total_ms(stats);
+            double exponent = previous_n>0 && previous_ms>0 ? std::log(ms/previous_ms)/std::log(n/previous_n) : NAN;
+            print_row( mode.name, n, stats, exponent );
+            previous_n = n;
+            previous_ms = ms;
+        }
+    }
+
+    // Coordinate magnitude and near-degenerate features, with meshing
+    const std::size_t n = std::min<std::size_t>( largest, 10000 );
+    struct Variant { const char *name; double offset; double degenerate; };
+    const Variant variants[] = {
+        { "origin",     0,   0.01 },
+        { "utm",        5e6, 0.01 },
+        { "utm-clean",  5e6, 0 },
+        { "utm-degen",  5e6, 0.1 },
+    };
+    std::printf( "\n" );
+    print_header("variant");
+    for( const Variant &variant : variants ) {
+        Generator_params params = params_for_size(n, variant.degenerate);
+        params.offset_x = variant.offset/10;
+        params.offset_y = variant.offset;
+        Tessa_stats stats;
+        if( !run(generate_polygon(params), modes[1], kernel, params.radius, stats) ) return 1;
+        print_row( variant.name, n, stats, NAN );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef INCLUDED_BATCH
+#define INCLUDED_BATCH
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// === Batch mode ===
+// The input is a stream of records, one per line: either just the geometry,
+// or a record id, a tab, and the geometry. An id has no '(' and no white
+// space, so a tab inside WKT is not taken for one. Records without an id are
+// named after their line number (counting from 1); empty lines are skipped.
+// Records are processed on a pool of worker threads, and the results are
+// written in input order as soon as all earlier ones are done.
+
+struct Batch_record {
+    std::string id;
+    std::string_view geometry;
+};
+
+inline std::vector<Batch_record> split_records( std::string_view data ) {
+    std::vector<Batch_record> records;
+    std::size_t line_number = 0;
+    while( !data.empty() ) {
+        std::size_t eol = std::min( data.find('\n'), data.size() );
+        std::string_view line = data.substr(0, eol);
+        data.remove_prefix( std::min(eol+1, data.size()) );
+        ++line_number;
+        if( !line.empty() && line.back()=='\r' ) line.remove_suffix(1);
+        if( line.find_first_not_of(" \t")==std::string_view::npos ) continue;
+        std::size_t tab = line.find('\t');
+        if( tab!=std::string_view::npos && line.substr(0,tab).find_first_of("( \t\v\f")!=std::string_view::npos ) {
+            tab = std::string_view::npos; // part of the geometry
+        }
+        if( tab==std::string_view::npos ) {
+            records.push_back({ std::to_string(line_number), line });
+        } else {
+            records.push_back({ std::string(line.substr(0,tab)), line.substr(tab+1) });
+        }
+    }
+    return records;
+}
+
+// Calls process(record) -> std::string on `jobs` threads and writes the
+// results to os in input order. If process throws, the result of that record
+// is on_error(record, what) instead. Returns the number of records.
+template<typename Process, typename On_error>
+std::size_t run_batch( const std::vector<Batch_record> &records, unsigned jobs, Process process, On_error on_error, std::ostream &os ) {
+    std::vector<std::string> results( records.size() );
+    std::vector<char> done( records.size(), false );
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::atomic<std::size_t> next{0};
+
+    auto work = [&]() {
+        for( std::size_t i=next++; i<records.size(); i=next++ ) {
+            std::string result;
+            try {
+                result = process(records[i]);
+            } catch( std::exception &x ) {
+                result = on_error(records[i], x.what());
+            } catch( ... ) {
+                result = on_error(records[i], "unknown error");
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                results[i] = std::move(result);
+                done[i] = true;
+            }
+            finished.notify_all();
+        }
+    };
+    jobs = std::max( 1u, std::min<unsigned>(jobs, records.size()) );
+    std::vector<std::thread> workers;
+    for( unsigned j=0; j<jobs; ++j ) workers.emplace_back(work);
+
+    // Write in order; free each result once it's out
+    for( std::size_t i=0; i<records.size(); ++i ) {
+        std::string result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait( lock, [&]{ return done[i]; } );
+            result.swap(results[i]);
+        }
+        os.write( result.data(), result.size() );
+    }
+    for( auto &worker : workers ) worker.join();
+    os.flush();
+    return records.size();
+}
+
+// Calls f(i) for i in [0,n) on `jobs` threads, in no particular order.
+template<typename F>
+void parallel_for( std::size_t n, unsigned jobs, F f ) {
+    std::atomic<std::size_t> next{0};
+    auto work = [&]() {
+        for( std::size_t i=next++; i<n; i=next++ ) f(i);
+    };
+    jobs = std::max( 1u, std::min<unsigned>(jobs, n) );
+    if( jobs==1 ) { work(); return; }
+    std::vector<std::thread> workers;
+    for( unsigned j=0; j<jobs; ++j ) workers.emplace_back(work);
+    for( auto &worker : workers ) worker.join();
+}
+
+#endif //ndef INCLUDED_BATCH
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef INCLUDED_CHAIN_INDEX
+#define INCLUDED_CHAIN_INDEX
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include "tessa_triangulation.h"
+
+// === Spatial index over the original chain edges ===
+// Answers "which original constraint does this (sub)edge lie on" with an
+// R-tree query on bounding boxes, followed by exact collinear-overlap tests
+// on the few candidates. Gives the same answer as find_edge_type_bruteforce:
+// if several chain edges overlap, the first one in map order wins.
+
+template < typename CDT >
+class Chain_edge_index {
+public:
+    typedef typename CDT::Vertex_handle Vertex_handle;
+    typedef typename CDT::Segment       Segment;
+
+    Chain_edge_index( const Chain_edges<CDT> &chain_edges ) {
+        segments.reserve(chain_edges.size());
+        types.reserve(chain_edges.size());
+        std::vector<Value> values;
+        values.reserve(chain_edges.size());
+        for( auto &edge : chain_edges ) {
+            Segment seg{ std::get<0>(edge.first)->point(), std::get<1>(edge.first)->point() };
+            values.emplace_back( box_of(seg), segments.size() );
+            segments.push_back(seg);
+            types.push_back(edge.second);
+        }
+        tree = Rtree(values); // bulk loading
+    }
+
+    // Type of the chain edge that overlaps segment ab, or -1 if there is none.
+    // Adds the number of overlap tests to *num_tests, if given.
+    int find_edge_type( Vertex_handle a, Vertex_handle b, std::size_t *num_tests = nullptr ) const {
+        Segment needle{ a->point(), b->point() };
+        std::size_t best = segments.size();
+        for( auto it = tree.qbegin(boost::geometry::index::intersects(box_of(needle))); it!=tree.qend(); ++it ) {
+            std::size_t i = it->second;
+            if( i>=best ) continue; // already have an earlier match
+            if( num_tests ) ++*num_tests;
+            if( overlaps(needle, segments[i]) ) best = i;
+        }
+        return best==segments.size() ? -1 : types[best];
+    }
+
+    std::size_t size() const { return segments.size(); }
+
+private:
+    typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> Box_point;
+    typedef boost::geometry::model::box<Box_point>                                   Box;
+    typedef std::pair<Box, std::size_t>                                              Value;
+    typedef boost::geometry::index::rtree<Value, boost::geometry::index::quadratic<16>> Rtree;
+
+    // Bounding boxes come from CGAL, so they are conservative even for exact points.
+    static Box box_of( const Segment &seg ) {
+        CGAL::Bbox_2 bb = seg.bbox();
+        return Box{ Box_point(bb.xmin(), bb.ymin()), Box_point(bb.xmax(), bb.ymax()) };
+    }
+
+    // Does the intersection of needle and hay have positive length?
+    static bool overlaps( const Segment &needle, const Segment &hay ) {
+        // cheap predicates first: overlapping segments are collinear
+        if( !CGAL::collinear(hay.source(), hay.target(), needle.source()) ) return false;
+        if( !CGAL::collinear(hay.source(), hay.target(), needle.target()) ) return false;
+        auto result = intersection(needle, hay);
+        return result && boost::get<Segment>(&*result);
+    }
+
+    std::vector<Segment> segments;
+    std::vector<int> types;
+    Rtree tree;
+};
+
+#endif //ndef INCLUDED_CHAIN_INDEX
\ No newline at end of file
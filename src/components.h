@@ -0,0 +1,72 @@
+#ifndef INCLUDED_COMPONENTS
+#define INCLUDED_COMPONENTS
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include "tessa_input.h"
+
+// === Splitting a multipolygon into independent components ===
+// The polygons of a multipolygon are disjoint, so each one can be triangulated
+// in its own CDT. Roads go with every polygon whose outer ring's bounding box
+// they touch: a road that crosses from one polygon into another shows up in
+// both, and each keeps the part inside its own domain; its vertices outside
+// that domain are output by one of them only (see tessellate). Roads that touch no
+// polygon at all go with the first one, which is what a single CDT would do
+// with them too (their vertices are output, the edges are not in the domain).
+
+namespace components {
+
+    typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> Box_point;
+    typedef boost::geometry::model::box<Box_point>                                   Box;
+
+    inline Box box_of( const parser::Points &points ) {
+        Box box;
+        boost::geometry::assign_inverse(box);
+        for( parser::Point p : points ) boost::geometry::expand( box, Box_point(p.x, p.y) );
+        return box;
+    }
+
+    // For each polygon, the indices of the linestrings that go with it, in input order
+    inline std::vector<std::vector<std::size_t>> assign_linestrings( const parser::TessaInput &input ) {
+        typedef std::pair<Box, std::size_t>                                                 Value;
+        typedef boost::geometry::index::rtree<Value, boost::geometry::index::quadratic<16>> Rtree;
+
+        std::vector<std::vector<std::size_t>> assigned( input.polygons.size() );
+        if( input.polygons.empty() ) return assigned; // no polygon to give the roads to
+        if( input.polygons.size()==1 ) {
+            for( std::size_t l=0; l<input.linestrings.size(); ++l ) assigned[0].push_back(l);
+            return assigned;
+        }
+
+        std::vector<Value> values;
+        values.reserve(input.polygons.size());
+        for( std::size_t i=0; i<input.polygons.size(); ++i ) {
+            if( input.polygons[i].empty() ) continue;
+            values.emplace_back( box_of(input.polygons[i][0]), i );
+        }
+        Rtree tree(values); // bulk loading
+
+        std::vector<std::size_t> hits;
+        for( std::size_t l=0; l<input.linestrings.size(); ++l ) {
+            if( input.linestrings[l].empty() ) continue;
+            hits.clear();
+            for( auto it = tree.qbegin(boost::geometry::index::intersects(box_of(input.linestrings[l]))); it!=tree.qend(); ++it ) {
+                hits.push_back(it->second);
+            }
+            if( hits.empty() ) hits.push_back(0);
+            for( std::size_t i : hits ) assigned[i].push_back(l);
+        }
+        return assigned;
+    }
+
+}
+
+#endif //ndef INCLUDED_COMPONENTS
\ No newline at end of file
@@ -15,50 +15,62 @@ using std::string;
 #include <vector>
 using std::vector;
 
-#include <map>
-using std::map;
-
-#include <tuple>
-using std::tuple;
-using std::get;
-
 #include <exception>
 using std::exception;
 
-#include <cmath>
-using std::sqrt;
+#include <filesystem>
+#include <memory>
+
+#include <tuple>
 
 // Commandline argument parser
 #include <CLI/CLI.hpp>
 
-// CGAL
-#include "tessa_triangulation.h"
+// The actual work
+#include "tessa.h"
+#include "snap.h" // usable_epsilon, to check --snap
 
 // logging
 #include "logging.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
-// Parse WKT
+// Read and parse input (WKT or WKB)
+#include "read_input.h"
 #include "parse_wkt.h"
-
-// For hiding "unused variable" warning
-template<typename... Args> inline void unused(Args&&...) {}
-
-void set_domain_from_rings( CDT &cdt, const vector<vector<Vertex_handle>> &polygon );
-void output_edge(Vertex_handle vh1, Vertex_handle vh2, string free_for, int type);
-Point construct_point_in_polygon(const vector<Vertex_handle> vhs);
-void insert_chain(CDT &cdt, const parser::Points&, vector<Vertex_handle>&, map<tuple<Vertex_handle,Vertex_handle>,int>&, int&, int&, int);
-int edge_type( Vertex_handle a, Vertex_handle b, map<tuple<Vertex_handle,Vertex_handle>,int>& );
-int find_edge_type_bruteforce(Vertex_handle a, Vertex_handle b, map<tuple<Vertex_handle, Vertex_handle>, int>&);
+#include "parse_wkb.h"
+
+// Writing output
+#include "tessa_mesh.h"
+#include "reorder.h"
+#include "write_mesh.h"
+#include "result_cache.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+// Many inputs per process
+#include "batch.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Server mode
+#ifndef _WIN32
+#include "serve.h"
+#endif
+
+string process_record( const Batch_record &record, const Tessa_options &options, const Result_cache *cache, bool &ok, Tessa_stats &stats );
+string handle_request( std::string_view request, const Tessa_options &defaults, std::shared_ptr<Tessa_incremental> &session );
 
 int main(int argc, char **argv) {
 
     // Commandline argument parsing
     CLI::App app("Tessa");
-    app.set_version_flag( "--version", "0.0.1" );
+    app.set_version_flag( "--version", tessa_version );
   
     std::string in_fname;
-    CLI::Option *in_fname_opt = app.add_option("-f,--file,file", in_fname, "Input file name; reads from stdin otherwise.")
+    CLI::Option *in_fname_opt = app.add_option("-f,--file,file", in_fname, "Input file name (WKT or WKB); reads from stdin otherwise.")
                               ->check(CLI::ExistingFile);
     
     std::string out_fname;
@@ -66,19 +78,63 @@ int main(int argc, char **argv) {
     
     CLI::Option *verbose = app.add_flag("-v,--verbose");
 
-    CLI::Option *op_cdt = app.add_flag("--cdt","Make into conforming Delaunay triangulation.");
+    Tessa_options options;
+
+    app.add_flag("--cdt",options.make_cdt,"Make into conforming Delaunay triangulation.");
     
-    CLI::Option *op_mesh = app.add_flag("--mesh","Make into mesh.");
-    double meshing_param_B{0.125};
-    app.add_option("--B",meshing_param_B,"Parameter B for meshing; see CGAL documentation.",true);
+    app.add_flag("--mesh",options.make_mesh,"Make into mesh.");
+    app.add_option("--B",options.meshing_param_B,"Parameter B for meshing; see CGAL documentation.",true);
 
-    double meshing_param_S{0};
-    app.add_option("--S",meshing_param_S,"Parameter S for meshing; see CGAL documentation. Zero means disabled.",true);
+    app.add_option("--S",options.meshing_param_S,"Parameter S for meshing; see CGAL documentation. Zero means disabled.",true);
     
-    CLI::Option *op_gabriel = app.add_flag("--gabriel","Make into conforming Gabriel graph.");
+    app.add_flag("--gabriel",options.make_gabriel,"Make into conforming Gabriel graph.");
+
+    app.add_option("--free-for", options.free_for, "String to put in the 'free_for' field of output edges." );
+
+    app.add_option("--repair", options.repair_method, "How to recover labels of subdivided edges: hierarchy, indexed or bruteforce.", true)
+       ->check(CLI::IsMember({"hierarchy","indexed","bruteforce"}));
+
+    std::string format{"text"};
+    app.add_option("--format", format, "Output format: text, or binary (mmappable CSR graph; see src/tessa_binary.h).", true)
+       ->check(CLI::IsMember({"text","binary"}));
+
+    app.add_option("--kernel", options.kernel, "Geometry kernel: epeck (exact constructions; robust) or epick (inexact constructions; fast).", true)
+       ->check(CLI::IsMember({"epeck","epick"}));
+
+    app.add_option("--max-vertices", options.max_vertices, "Stop refining at this many vertices; the output is then partial (exit code 4). 0 means no limit.", true);
+    app.add_option("--time-limit", options.time_limit, "Stop refining after this many seconds; the output is then partial (exit code 4). 0 means no limit.", true);
+
+    app.add_option("--snap", options.snap, "Merge input points closer than this to each other first, dropping the segments that become zero length. 0 means not.", true);
+    app.add_option("--simplify", options.simplify, "Simplify rings and roads first (Douglas-Peucker, keeping the topology), removing points at most this far from the result. 0 means not.", true);
+
+    app.add_option("--validate", options.validate, "Look for unclosed rings, rings crossing themselves or each other, and roads crossing rings first: off, warn (log them), or reject (log them and exit with code 5).", true)
+       ->check(CLI::IsMember({"off","warn","reject"}));
+
+    app.add_option("--reorder", options.reorder, "Number the vertices along a space-filling curve (hilbert or morton), and sort the edges by their vertices.", true)
+       ->check(CLI::IsMember({"none","hilbert","morton"}));
+    std::string id_map_fname;
+    app.add_option("--id-map", id_map_fname, "With --reorder: write 'new id;old id' for every vertex to this file; old ids are the ids without --reorder, with the input vertices first, in input order.");
+
+    CLI::Option *op_batch = app.add_flag("--batch","Batch mode: the input has one WKT record per line, optionally preceded by a record id and a tab.");
+    options.jobs = std::max(1u, std::thread::hardware_concurrency());
+    app.add_option("-j,--jobs", options.jobs, "Number of worker threads, for the records in batch mode, the polygons of a multipolygon, or the tiles.", true);
+    app.add_option("--tiles", options.tiles, "With --mesh: cut each polygon into an N by N grid of tiles and mesh those in parallel.", true)
+       ->check(CLI::Range(1,1000));
+
+    CLI::Option *op_serve = app.add_flag("--serve","Server mode: answer length-prefixed requests on stdin, or on --socket; see src/serve.h.");
+    std::string socket_path;
+    app.add_option("--socket", socket_path, "With --serve: listen on this Unix domain socket instead of stdin.");
+
+    std::string stats_fname;
+    app.add_option("--stats", stats_fname, "Write the time spent in each stage, and counters, to this file as JSON; see src/stats.h.");
+
+    app.add_flag("--lean", options.lean, "Keep peak memory down: drop the input text after parsing and the input after tessellating, free the helper maps before collecting the mesh, and size the output arrays exactly. Edge lengths then come from the double coordinates.");
+
+    std::string cache_dir;
+    app.add_option("--cache-dir", cache_dir, "Keep results in this directory, under a hash of the parsed input and the options, and reuse them; see src/result_cache.h.");
 
-    std::string free_for;
-    app.add_option("--free-for", free_for, "String to put in the 'free_for' field of output edges." );
+    std::string snapshot_fname;
+    app.add_option("--snapshot", snapshot_fname, "With --mesh: keep the triangulation in this file, and re-mesh only around the holes and roads that changed since.");
 
     CLI11_PARSE(app,argc,argv);
 
@@ -88,327 +144,349 @@ int main(int argc, char **argv) {
 	if( *verbose ) console->set_level(spdlog::level::info);
 	else console->set_level(spdlog::level::err);
 
-    // Set up input stream; redirect cin from file?
-    ifstream fin;
-    if( in_fname_opt->count() > 0 ) {
-        fin.open(in_fname);
-        cin.rdbuf(fin.rdbuf());
+    if( !snap::usable_epsilon(options.snap) ) {
+        console->error("--snap takes 0 or an epsilon of at least {}.", snap::min_epsilon);
+        return 2;
+    }
+
+
+    // Server mode: the options given here are the defaults for every request
+    if( *op_serve ) {
+#ifdef _WIN32
+        console->error("Server mode is not available on Windows.");
+        return 2;
+#else
+        // Each connection gets its own copy of handle, and so its own session
+        auto handle = [options, session=std::shared_ptr<Tessa_incremental>()]( std::string_view request ) mutable {
+            return handle_request(request, options, session);
+        };
+        if( !socket_path.empty() ) return serve::serve_socket(socket_path, handle);
+        serve::serve_fd(0, 1, handle);
+        return 0;
+#endif
+    }
+
+    // --cache-dir
+    Result_cache cache;
+    bool use_cache = false;
+    if( !cache_dir.empty() ) {
+        if( !Result_cache::cacheable(options) ) console->info("Not using the cache: results with --time-limit vary");
+        else use_cache = cache.open(cache_dir);
     }
 
     // Set up output stream; redirect cout to file?
     ofstream fout;
     if( out_fname_opt->count() > 0 ) {
-        fout.open(out_fname);
+        fout.open(out_fname, format=="binary" ? std::ios::out|std::ios::binary : std::ios::out);
         cout.rdbuf(fout.rdbuf());
     }
-    cout << std::fixed << std::setprecision(7); // we don't want scientific notation
+#ifdef _WIN32
+    else if( format=="binary" ) _setmode( _fileno(stdout), _O_BINARY );
+#endif
+
+    // --stats: written at the end, if we get there
+    Tessa_stats stats;
+    auto write_stats = [&]() {
+        if( stats_fname.empty() ) return;
+        stats.peak_rss_bytes = peak_rss_bytes();
+        stats.allocations = allocation_count();
+        ofstream stats_out(stats_fname);
+        write_stats_json(stats_out, stats, in_fname);
+        if( !stats_out ) console->error("Cannot write {}", stats_fname);
+    };
+
+    // Read entire input: map the file, or read all of stdin
+    Input_data input_data;
+    {
+        Stage_timer timer(stats.read_ms);
+        if( in_fname_opt->count() > 0 ) {
+            if( !input_data.open_file(in_fname) ) return 2;
+        } else {
+#ifdef _WIN32
+            _setmode( _fileno(stdin), _O_BINARY ); // WKB must not get CR/LF translated
+#endif
+            input_data.read_stream(cin);
+        }
+    }
 
-    // Read entire input
-    string wkt_string;
-    cin.unsetf( std::ios::skipws ); // don't skip whitespace
-    std::copy( std::istream_iterator<char>(cin), std::istream_iterator<char>(), std::back_inserter(wkt_string) );
+    // Batch mode: tessellate many records in parallel
+    if( *op_batch ) {
+        if( format!="text" ) {
+            console->error("Batch mode only writes the text format.");
+            return 2;
+        }
+        auto records = split_records( input_data.view() );
+        console->info("Batch of {} records on {} threads", records.size(), options.jobs);
+        std::atomic<size_t> failed{0};
+        std::mutex stats_mutex;
+        run_batch( records, options.jobs, [&]( const Batch_record &record ) {
+            bool ok = false;
+            Tessa_stats record_stats;
+            string result = process_record(record, options, use_cache ? &cache : nullptr, ok, record_stats);
+            if( !ok ) ++failed;
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            stats += record_stats;
+            return result;
+        }, [&]( const Batch_record &record, const char *what ) {
+            console->error("Record {} failed: {}", record.id, what);
+            ++failed;
+            return "record;" + record.id + ";error\n";
+        }, cout );
+        write_stats();
+        if( use_cache ) console->info("Cache: {} hits, {} misses", stats.cache_hits, stats.cache_misses);
+        if( failed>0 ) {
+            console->error("{} of {} records failed", failed.load(), records.size());
+            return 2;
+        }
+        console->info("Done.");
+        return 0;
+    }
 
-    // Parse a single wkt polygon
-    // Watch out 1: A input.polygon can consist multiple rings
+    // Parse a single polygon, as WKT or WKB
+    // Watch out 1: A polygon in input.polygons can consist multiple rings
     // Watch out 2: These rings are not closed implicitly; the last input vertex
     //              should be the same as the first; we don't close it.
-    auto [success,input] = parser::parse_wkt_polygon(wkt_string);
+    bool success;
+    parser::TessaInput input;
+    {
+        Stage_timer timer(stats.parse_ms);
+        std::tie(success, input) = parser::looks_like_wkb(input_data.view()) ? parser::parse_wkb(input_data.view())
+                                                                            : parser::parse_wkt_polygon(input_data.view());
+    }
     if( !success ) {
         return 2;
     }
-
-    // Iterate over the rings of the parsed polygon:
-    // Add all line segments to the CDT
-    // Vertex ids are assigned consecutively from 0
-    CDT cdt;
-    int index = 0;
-    map<tuple<Vertex_handle,Vertex_handle>,int> chain_edges; // vector of edge sets of the rings/chains
-    vector<vector<Vertex_handle>> cgal_polygon; // vector of rings; index 0 is outer ring
-    cgal_polygon.reserve(input.polygon.size()+input.linestrings.size());
-    int num_edges_inserted = 0;
-    int type = 0; // type of edges: first ring has type 0
-    for( auto &ring : input.polygon ) {
-        cgal_polygon.emplace_back();
-        insert_chain( cdt, ring, cgal_polygon.back(), chain_edges, index, num_edges_inserted, type );
-        type = 1; // further rings have type 1
-    }
-    // Now also add all the linestrings from the multilinestring. (Could be empty.)
-    for( auto &chain : input.linestrings ) {
-        cgal_polygon.emplace_back();
-        insert_chain( cdt, chain, cgal_polygon.back(), chain_edges, index, num_edges_inserted, 2 );
-    }
-    console->info("Number of input vertices: {}", cdt.number_of_vertices() );
-    console->info("Number of edges inserted: {}", num_edges_inserted );
-
-    // Try to come up with a point *inside* each hole.
-    // Currently puts it just slightly inside a corner; not guaranteed to work.
-    std::list<Point> list_of_seeds;
-    for( unsigned long i=1; i<input.polygon.size(); ++i ) {
-        // if this polygon is a ring (and not a path), put a seed point in it
-        //if( cgal_polygon.front()==cgal_polygon.back() ) {
-            Point seed = construct_point_in_polygon(cgal_polygon[i]);
-            list_of_seeds.push_back(seed);
-        //}
-    }
-
-
-    // keep track of if we did something so we can give a warning
-    // *and* because we give different output in that case
-    bool did_something = false;
-    bool should_repair_labels = false;
-
-    // make cdt?
-    if( *op_cdt ) {
-        did_something = true;
-        console->info("Making conforming Delauney triangulation...");
-        try {
-            CGAL::make_conforming_Delaunay_2(cdt);
-            set_domain_from_rings( cdt, cgal_polygon );
-        } catch( exception &x ) {
-            console->error(x.what());
+    if( options.lean ) input_data.release();
+
+    // A cached result goes straight to the output. Not with --snapshot or
+    // --id-map: those write files of their own.
+    string cache_key;
+    if( use_cache && snapshot_fname.empty() && id_map_fname.empty() ) {
+        cache_key = Result_cache::key(input, options, format);
+        int cached_result = 0;
+        if( cache.fetch(cache_key, cached_result, cout) ) {
+            ++stats.cache_hits;
+            console->info("Cache hit: {}", cache_key);
+            cout.flush();
+            write_stats();
+            return cached_result;
         }
-        console->info("Number of vertices is now: {}", cdt.number_of_vertices() );
+        ++stats.cache_misses;
+        console->info("Cache miss: {}", cache_key);
     }
 
-    // make mesh?
-    if( *op_mesh ) {
-        did_something = true;
-        should_repair_labels = true;
-        console->info("Making mesh with parameters B={} and S={} ...", meshing_param_B, meshing_param_S);
-        Criteria crit(meshing_param_B,meshing_param_S);
-        CGAL::refine_Delaunay_mesh_2(cdt, list_of_seeds.begin(), list_of_seeds.end(), crit);
-        // this function already sets the domain correctly (holes/nonholes)
-
-        console->info("Number of vertices is now: {}", cdt.number_of_vertices() );
-    }
-
-    // make conforming Gabriel?
-    if( *op_gabriel ) {
-        did_something = true;
-        should_repair_labels = true;
-        console->info("Making conforming Gabriel graph...");
-        try {
-            CGAL::make_conforming_Gabriel_2(cdt);
-            set_domain_from_rings( cdt, cgal_polygon );
-        } catch( exception &x ) {
-            console->error(x.what());
+    Tessa_mesh mesh;
+    int result = 0;
+    if( snapshot_fname.empty() ) {
+        result = tessellate(input, options, mesh, &stats);
+    } else {
+        if( !options.make_mesh || options.make_cdt || options.make_gabriel || options.tiles>1 ) {
+            console->error("--snapshot only works with just --mesh, in one tile.");
+            return 2;
         }
-        console->info("Number of vertices is now: {}", cdt.number_of_vertices() );
-    }
-
-    // Reconstruct original labels if we may have messed them up
-    if( should_repair_labels ) {
-        console->info("Repairing labels");
-        // This is before cleaning up the ids, so any newly introduced points have id -1
-        // Adjacent edges could be mesh edges, which is fine, but maybe we subdivided
-        // a "boundary", "hole" or "road" edge.
-        map<tuple<Vertex_handle,Vertex_handle>,int> new_chain_edges;
-        for( auto ei : cdt.finite_edges() ) {
-            CDT::Face& f = *(ei.first);
-            int i = ei.second;
-            auto vh1 = f.vertex(f.cw(i));
-            auto vh2 = f.vertex(f.ccw(i));
-            if (vh1->id() == -1 || vh2->id() == -1) {
-                // At least one of the vertices is new; we need to check it
-                int original_type = find_edge_type_bruteforce(vh1, vh2, chain_edges);
-                if( original_type != -1 ) {
-                    //console->info("The segment ({},{})-({},{}) is actually of type {}", vh1->point().x(), vh1->point().y(), vh2->point().x(), vh2->point().y(), original_type);
-                    new_chain_edges[{vh1,vh2}] = original_type;
-                }
-            }
+        if( options.kernel!="epeck" ) {
+            console->error("--snapshot only works with --kernel=epeck: inexact refinement points are not exactly on the constraints they split.");
+            return 2;
         }
-        chain_edges.merge(new_chain_edges);
-        console->info("Done repairing edges");
-    }
-
-    // Clean up data structure
-    if( did_something ) {
-        // give ids to any vertices that were introduced
-        for( auto vh : cdt.finite_vertex_handles() ) {
-            if( vh->id()==-1 ) vh->id() = index++;
+        Tessa_incremental incremental(options);
+        ifstream snapshot_in(snapshot_fname);
+        if( snapshot_in && !incremental.load(snapshot_in) ) {
+            console->warn("Ignoring snapshot {}", snapshot_fname);
         }
-    } else {
-        console->warn("Did not do anything to the input.");
+        result = incremental.update(input, mesh);
+        // Write a new snapshot next to the old one, and swap them
+        string tmp_fname = snapshot_fname + ".tmp";
+        ofstream snapshot_out(tmp_fname);
+        incremental.save(snapshot_out);
+        snapshot_out.close();
+        std::error_code error;
+        if( snapshot_out ) std::filesystem::rename(tmp_fname, snapshot_fname, error);
+        if( !snapshot_out || error ) console->error("Cannot write snapshot {}", snapshot_fname);
     }
-
-
-    // === Output
-
-    cout << cdt.number_of_vertices() << "\n";
-    int num_edges = 0; // there is no number_of_edges?
-    for( auto ei : cdt.finite_edges() ) { unused(ei); ++num_edges; } // count edges "by hand" instead
-    cout << num_edges << "\n";
-
-    { // Output vertices
-        int check_index = 0;
-        bool warned_bad_ids = false;
-        for(auto vh : cdt.finite_vertex_handles() ) {
-            if( vh->id()!=check_index++ && !warned_bad_ids ) {
-                console->error("Watch out! Vertex ids are not consecutive from 0.");
-                warned_bad_ids = true;
+    if( result==tessa_invalid ) {
+        write_stats();
+        return result;
+    }
+    if( options.lean ) input = parser::TessaInput(); // the mesh is all we need now
+
+    if( options.reorder!="none" ) {
+        Stage_timer timer(stats.id_cleanup_ms);
+        auto old_ids = reorder::reorder_mesh(mesh, options.reorder);
+        if( !id_map_fname.empty() ) {
+            ofstream id_map_out(id_map_fname);
+            Output_writer out(&id_map_out);
+            for( size_t i=0; i<old_ids.size(); ++i ) {
+                out.put( i );
+                out.put( ';' );
+                out.put( old_ids[i] );
+                out.put( '\n' );
             }
-            cout << vh->id() << ";" << vh->point().x() << ";" << vh->point().y() << "\n";
+            out.flush();
+            if( !id_map_out ) console->error("Cannot write {}", id_map_fname);
         }
     }
 
-    // Output edges
-    if( did_something ) {
-        // output triangulation edges
-        for( auto ei : cdt.finite_edges() ) {
-            CDT::Face& f = *(ei.first);
-            int i = ei.second;
-            auto other_f = f.neighbor(i);
-            if( f.is_in_domain() || other_f->is_in_domain() ) {
-                auto vh1 = f.vertex(f.cw(i));
-                auto vh2 = f.vertex(f.ccw(i));
-                int type = edge_type(vh1,vh2,chain_edges);
-                output_edge( vh1, vh2, free_for, type);
+    // === Output
+    // Into a buffer first if it goes to the cache too
+    {
+        Stage_timer timer(stats.output_ms);
+        std::ostringstream captured;
+        ostream &os = cache_key.empty() ? cout : captured;
+        if( format=="binary" ) {
+            if( !write_binary(os, mesh, options.free_for) ) {
+                console->error("The binary format is little-endian; this machine is not.");
+                return 3;
             }
+        } else {
+            Output_writer out(&os);
+            write_text(out, mesh, options.free_for);
         }
-    } else {
-        // spit out original edges
-        for( auto &ring : cgal_polygon ) {
-            Vertex_handle vh1 = ring[0];
-            for( Vertex_handle vh2 : ring ) {
-                if( vh1!=vh2 ) {
-                    int type = edge_type(vh1,vh2,chain_edges);
-                    output_edge( vh1, vh2, free_for, type);
-                }
-                vh1 = vh2;
-            }
+        if( !cache_key.empty() ) {
+            const string output = captured.str();
+            cout.write(output.data(), output.size());
+            cache.store(cache_key, result, output);
         }
+        cout.flush();
     }
-
+    write_stats();
 
     // And we're done.
     console->info("Done.");
-
+    return result;
 }
 
-bool point_is_in_domain( Point p, const vector<vector<Point>> &polygon ) {
-    // outside the outer ring? not in the domain
-    if( CGAL::bounded_side_2(polygon[0].begin(), polygon[0].end(), p, K()) != CGAL::ON_BOUNDED_SIDE ) return false;
-    // are we in any of the holes? not in the domain
-    for( size_t i=1; i<polygon.size(); ++i ) {
-        if( CGAL::bounded_side_2(polygon[i].begin(), polygon[i].end(), p, K()) == CGAL::ON_BOUNDED_SIDE ) return false;
+// One batch record in, its text output out. The output starts with a line
+// "record;<id>;ok" followed by the usual text format, or is the single line
+// "record;<id>;error" if the record could not be parsed or tessellated.
+// If refinement ran out of budget, the first line is "record;<id>;partial".
+string process_record( const Batch_record &record, const Tessa_options &options, const Result_cache *cache, bool &ok, Tessa_stats &stats ) {
+    Output_writer out( nullptr, 1<<12 );
+    out.put( "record;" );
+    out.put( record.id );
+    bool success;
+    parser::TessaInput input;
+    {
+        Stage_timer timer(stats.parse_ms);
+        std::tie(success, input) = parser::parse_wkt_polygon(record.geometry);
     }
-    // otherwise we're good
-    return true;
-}
-void set_domain_from_rings( CDT &cdt, const vector<vector<Vertex_handle>> &vhs ) {
-    // assumption: faces are triangles
-    vector<vector<Point>> polygon;
-    polygon.reserve(vhs.size());
-    for( const vector<Vertex_handle> &ring : vhs ) {
-        polygon.emplace_back();
-        polygon.back().reserve(ring.size());
-        for( Vertex_handle vh : ring ) {
-            polygon.back().emplace_back(vh->point());
-        }
-    }
-    for( auto f : cdt.all_face_handles() ) {
-        // is the centroid in the polygon outer ring, but not in any of the holes?
-        Vertex_handle vh0 = f->vertex(0);
-        Vertex_handle vh1 = f->vertex(1);
-        Vertex_handle vh2 = f->vertex(2);
-        Point centroid = vh0->point() + 0.33*(vh1->point()-vh0->point()) + 0.33*(vh2->point()-vh0->point());
-        f->set_in_domain( point_is_in_domain(centroid,polygon) );
+    if( !success ) {
+        console->error("Record {} does not parse", record.id);
+        out.put( ";error\n" );
+        return out.take_str();
     }
-}
-
-Point construct_point_in_polygon(const vector<Vertex_handle> vhs) {
-    // Take three adjacent points on the first ring
-    Point a = vhs[0]->point();
-    Point b = vhs[1]->point();
-    Point c = vhs[2]->point();
-    // Assume abc is a convex turn: then seed is probably inside
-    Point seed = b + 0.0001*((a-b) + (c-b));
-    // See if we're actually inside
-    vector<Point> testpoly;
-    testpoly.reserve(vhs.size());
-    for( auto vh : vhs ) testpoly.emplace_back(vh->point());
-    bool inside = CGAL::bounded_side_2(testpoly.begin(), testpoly.end(),seed, K())==CGAL::ON_BOUNDED_SIDE;
-    if( inside ) {
-        console->info("Seed is inside the hole on first attempt");
-    } else {
-        seed = b - 0.01*((a-b) + (c-b));
-        inside = CGAL::bounded_side_2(testpoly.begin(), testpoly.end(),seed, K())==CGAL::ON_BOUNDED_SIDE;
-        if( inside ) {
-            console->info("Seed inside the hole on second attempt");
-        } else {
-            console->error("Seed point not in the hole :(. Result will be bad.");
+    Tessa_options record_options = options;
+    record_options.jobs = 1; // the records are already spread over the threads
+
+    // Cache entries hold the text format, as for single inputs
+    string cache_key;
+    if( cache ) {
+        cache_key = Result_cache::key(input, record_options, "text");
+        std::ostringstream cached;
+        int cached_result = 0;
+        if( cache->fetch(cache_key, cached_result, cached) ) {
+            ++stats.cache_hits;
+            ok = true;
+            out.put( cached_result==tessa_partial ? ";partial\n" : ";ok\n" );
+            out.put( cached.str() );
+            return out.take_str();
         }
+        ++stats.cache_misses;
     }
-    return seed;
-}
 
-string type_name(int type) {
-    switch(type) {
-    case 0: return "boundary";
-    case 1: return "hole";
-    case 2: return "road";
-    case 3: return "mesh";
-    default: return "unknown";
+    Tessa_mesh mesh;
+    int result = 0;
+    try {
+        result = tessellate(input, record_options, mesh, &stats);
+    } catch( std::exception &x ) {
+        console->error("Record {} failed: {}", record.id, x.what());
+        out.put( ";error\n" );
+        return out.take_str();
     }
-}
-void output_edge(Vertex_handle vh1, Vertex_handle vh2, string free_for, int type) {
-    string bidirectional = "1";
-    double distance = to_double( (vh1->point()-vh2->point()).squared_length() );
-    cout << vh1->id() << ";";
-    cout << vh2->id() << ";";
-    cout << distance << ";";
-    cout << free_for << ";";
-    cout << bidirectional << ";";
-    cout << type_name(type) << ";\n";
-}
-
-void insert_chain(CDT &cdt, const parser::Points& chain, vector<Vertex_handle>& cgal_polygon, map<tuple<Vertex_handle,Vertex_handle>,int> &chain_edges, int &index, int &num_edges_inserted, int type ) {
-    cgal_polygon.reserve(chain.size());
-    for( parser::Point p : chain ) {
-        cgal_polygon.emplace_back( cdt.insert(Point(p.x, p.y)) );
-        auto &v = cgal_polygon.back();
-        if( v->id()==-1 ) v->id() = index++; // only assign id if this vertex is new (-1 is default value)
+    if( result==tessa_invalid ) {
+        console->error("Record {} is invalid", record.id);
+        out.put( ";error\n" );
+        return out.take_str();
     }
-    int n = cgal_polygon.size();
-    if( n==1 ) return; // don't try to make edges if we have only a single vertex
-    for( int i=0; i<n-1; ++i ) {
-        if (cgal_polygon[i]->id() == cgal_polygon[i + 1]->id()) {
-            //console->warn("Skipping a length-zero edge at {} {}", cgal_polygon[i]->point().x(), cgal_polygon[i]->point().y());
-            continue;
-        }
-        cdt.insert_constraint( cgal_polygon[i], cgal_polygon[i+1] );
-        console->info("Inserting edge {} - {} with type {}",cgal_polygon[i]->id(), cgal_polygon[i+1]->id(), type );
-        chain_edges[{cgal_polygon[i],cgal_polygon[i+1]}] = type;
-        ++num_edges_inserted;
+    ok = true;
+    if( options.reorder!="none" ) reorder::reorder_mesh(mesh, options.reorder);
+    Stage_timer timer(stats.output_ms);
+    out.put( result==tessa_partial ? ";partial\n" : ";ok\n" );
+    if( cache ) {
+        Output_writer body( nullptr, 1<<12 );
+        write_text(body, mesh, options.free_for);
+        string text = body.take_str();
+        cache->store(cache_key, result, text);
+        out.put( text );
+    } else {
+        write_text(out, mesh, options.free_for);
     }
+    return out.take_str();
 }
 
-int edge_type( Vertex_handle a, Vertex_handle b, map<tuple<Vertex_handle,Vertex_handle>,int> &chain_edges ) {
-    auto known_edge = chain_edges.find({a,b});
-    if( known_edge!=chain_edges.end() ) return known_edge->second;
-    // tuple might be the other way around: check that too if we didn't find yet
-    known_edge = chain_edges.find({b,a});
-    if( known_edge!=chain_edges.end() ) return known_edge->second;
-    return 3; // we didn't add it, so it's a mesh edge. well, or a subdivided edge :(
-}
+// One request in server mode: a line of options, then the input; see serve.h.
+// With --incremental, the request updates the mesh of the session, which
+// lives as long as the connection; see Tessa_incremental.
+string handle_request( std::string_view request, const Tessa_options &defaults, std::shared_ptr<Tessa_incremental> &session ) {
+    size_t eol = std::min( request.find('\n'), request.size() );
+    string option_line( request.substr(0, eol) );
+    std::string_view data = request.substr( std::min(eol+1, request.size()) );
+
+    Tessa_options options = defaults;
+    CLI::App app("Tessa request");
+    app.add_flag("--cdt", options.make_cdt);
+    app.add_flag("--mesh", options.make_mesh);
+    app.add_flag("--gabriel", options.make_gabriel);
+    app.add_option("--B", options.meshing_param_B);
+    app.add_option("--S", options.meshing_param_S);
+    app.add_option("--free-for", options.free_for);
+    app.add_option("--max-vertices", options.max_vertices);
+    app.add_option("--time-limit", options.time_limit);
+    app.add_option("--snap", options.snap);
+    app.add_option("--simplify", options.simplify);
+    app.add_option("--validate", options.validate)->check(CLI::IsMember({"off","warn","reject"}));
+    app.add_option("--reorder", options.reorder)->check(CLI::IsMember({"none","hilbert","morton"}));
+    bool incremental = false;
+    app.add_flag("--incremental", incremental);
+    try {
+        app.parse(option_line, false);
+    } catch( const CLI::ParseError &x ) {
+        console->error("Bad request options '{}': {}", option_line, x.what());
+        return "error\n";
+    }
+    if( !snap::usable_epsilon(options.snap) ) {
+        console->error("Bad request options '{}': --snap takes 0 or an epsilon of at least {}", option_line, snap::min_epsilon);
+        return "error\n";
+    }
 
-int find_edge_type_bruteforce( Vertex_handle a, Vertex_handle b, map<tuple<Vertex_handle, Vertex_handle>, int> &chain_edges ) {
-    Segment needle{ a->point(), b->point() };
-    for (auto &hay : chain_edges) {
-        Point p1 = get<0>(hay.first)->point();
-        Point p2 = get<1>(hay.first)->point();
-        Segment seg{ p1, p2 };
-
-        auto result = intersection(needle, seg);
-        if (result) {
-            // There is an intersection, but is it a segment or a point?
-            if( boost::get<Segment>(&*result) ) {
-                // The intersection is a segment! Return the type of the overlapping segment.
-                return hay.second;
+    auto [success,input] = parser::looks_like_wkb(data) ? parser::parse_wkb(data) : parser::parse_wkt_polygon(data);
+    if( !success ) return "error\n";
+    Tessa_mesh mesh;
+    int result = 0;
+    try {
+        if( incremental ) {
+            options.make_mesh = true;
+            options.make_cdt = options.make_gabriel = false;
+            if( !session || session->options().meshing_param_B!=options.meshing_param_B
+                         || session->options().meshing_param_S!=options.meshing_param_S
+                         || session->options().max_vertices!=options.max_vertices
+                         || session->options().time_limit!=options.time_limit
+                         || session->options().snap!=options.snap
+                         || session->options().simplify!=options.simplify
+                         || session->options().validate!=options.validate ) {
+                session = std::make_shared<Tessa_incremental>(options);
             }
+            result = session->update(input, mesh);
+        } else {
+            result = tessellate(input, options, mesh);
         }
-
+    } catch( std::exception &x ) {
+        console->error("Request failed: {}", x.what());
+        return "error\n";
     }
-    // does not overlap any original edges
-    return -1;
+    if( result==tessa_invalid ) return "error\n";
+    if( options.reorder!="none" ) reorder::reorder_mesh(mesh, options.reorder);
+    Output_writer out( nullptr, 1<<12 );
+    out.put( result==tessa_partial ? "partial\n" : "ok\n" );
+    write_text(out, mesh, options.free_for);
+    return out.take_str();
 }
\ No newline at end of file
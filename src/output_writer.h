@@ -0,0 +1,80 @@
+#ifndef INCLUDED_OUTPUT_WRITER
+#define INCLUDED_OUTPUT_WRITER
+
+#include <charconv>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// === Buffered text writer ===
+// Formats numbers with std::to_chars into a big block of memory and hands
+// that to the stream in one go, instead of going through iostream formatting
+// field by field. Numbers come out exactly like they would from an ostream
+// set to std::fixed and std::setprecision(7).
+// Without a stream, it just collects everything; see str() and append().
+
+class Output_writer {
+public:
+    explicit Output_writer( std::ostream *os = nullptr, std::size_t block_size = 1<<20 )
+        : os(os), block_size(block_size) {
+        buffer.reserve( os ? block_size+max_number_length : block_size );
+    }
+    ~Output_writer() { flush(); }
+    Output_writer( const Output_writer& ) = delete;
+    Output_writer &operator=( const Output_writer& ) = delete;
+
+    void put( char c ) {
+        buffer.push_back(c);
+        flush_if_full();
+    }
+    void put( std::string_view s ) {
+        buffer.append(s.data(), s.size());
+        flush_if_full();
+    }
+    void put( long long value ) {
+        char tmp[24];
+        auto result = std::to_chars(tmp, tmp+sizeof(tmp), value);
+        buffer.append(tmp, result.ptr);
+        flush_if_full();
+    }
+    void put( int value ) { put( static_cast<long long>(value) ); }
+    void put( std::size_t value ) { put( static_cast<long long>(value) ); }
+    void put_fixed( double value, int precision = 7 ) {
+        char tmp[max_number_length];
+        auto result = std::to_chars(tmp, tmp+sizeof(tmp), value, std::chars_format::fixed, precision);
+        buffer.append(tmp, result.ptr);
+        flush_if_full();
+    }
+
+    // Copy everything another (collecting) writer has gathered
+    void append( const Output_writer &other ) {
+        buffer.append(other.buffer);
+        flush_if_full();
+    }
+
+    // Hand the buffer to the stream; does nothing for a collecting writer
+    void flush() {
+        if( !os || buffer.empty() ) return;
+        os->write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    const std::string &str() const { return buffer; }
+    // Move out what a collecting writer has gathered, leaving it empty
+    std::string take_str() { return std::exchange(buffer, std::string()); }
+
+private:
+    // longest possible fixed-notation double: sign, 309 digits, point, decimals
+    static constexpr std::size_t max_number_length = 400;
+
+    void flush_if_full() {
+        if( os && buffer.size()>=block_size ) flush();
+    }
+
+    std::ostream *os;
+    std::size_t block_size;
+    std::string buffer;
+};
+
+#endif //ndef INCLUDED_OUTPUT_WRITER
\ No newline at end of file
@@ -0,0 +1,203 @@
+#ifndef INCLUDED_PARSE_WKB
+#define INCLUDED_PARSE_WKB
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include "logging.h"
+#include "parse_wkt.h" // for TessaInput
+
+// === Well-known binary ===
+// Accepts the same shapes as the WKT grammar: a Polygon or MultiPolygon, or a
+// GeometryCollection of Polygons and MultiPolygons, optionally followed by one
+// MultiLineString.
+// Both byte orders are fine, as are EWKB (PostGIS) SRIDs and ISO/EWKB Z and M
+// coordinates; those extra coordinates are dropped.
+
+namespace parser {
+
+    // WKB starts with a byte order marker, WKT with a letter or whitespace
+    inline bool looks_like_wkb( std::string_view data ) {
+        return !data.empty() && (data[0]=='\x00' || data[0]=='\x01');
+    }
+
+    class Wkb_reader {
+    public:
+        explicit Wkb_reader( std::string_view data ) : data(data) {}
+
+        struct Error {
+            std::size_t pos;
+            std::string what;
+        };
+
+        TessaInput tessa_input() {
+            TessaInput input;
+            Geometry g = geometry_header();
+            if( g.type==geometrycollection_type ) {
+                std::uint32_t n = count(g, 9); // smallest possible member: header and a count
+                if( n<1 ) fail("expected a geometrycollection of polygons and optionally a multilinestring");
+                for( std::uint32_t i=0; i<n; ++i ) {
+                    Geometry m = geometry_header();
+                    if( i>0 && i==n-1 && m.type==multilinestring_type ) {
+                        input.linestrings = multilinestring_body(m);
+                    } else if( !polygonal(m, input.polygons) ) {
+                        fail(i==0 ? "expected a polygon or a multipolygon" : "expected a polygon, a multipolygon or a multilinestring");
+                    }
+                }
+            } else if( !polygonal(g, input.polygons) ) {
+                fail("expected a polygon, a multipolygon or a geometrycollection");
+            }
+            return input;
+        }
+
+        std::size_t position() const { return pos; }
+
+    private:
+        static constexpr std::uint32_t linestring_type = 2;
+        static constexpr std::uint32_t polygon_type = 3;
+        static constexpr std::uint32_t multilinestring_type = 5;
+        static constexpr std::uint32_t multipolygon_type = 6;
+        static constexpr std::uint32_t geometrycollection_type = 7;
+
+        struct Geometry {
+            bool swap;           // byte order differs from ours
+            std::uint32_t type;  // 2D base type
+            int dimensions;      // 2, 3 or 4 doubles per point
+        };
+
+        [[noreturn]] void fail( const std::string &what ) const { throw Error{pos, what}; }
+
+        void need( std::size_t bytes ) const {
+            if( data.size()-pos<bytes ) fail("unexpected end of input");
+        }
+
+        static bool host_is_little_endian() {
+            const std::uint16_t one = 1;
+            unsigned char first;
+            std::memcpy(&first, &one, 1);
+            return first==1;
+        }
+
+        template<typename T> T read( bool swap ) {
+            need(sizeof(T));
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, data.data()+pos, sizeof(T));
+            pos += sizeof(T);
+            if( swap ) {
+                for( std::size_t i=0; i<sizeof(T)/2; ++i ) std::swap(bytes[i], bytes[sizeof(T)-1-i]);
+            }
+            T value;
+            std::memcpy(&value, bytes, sizeof(T));
+            return value;
+        }
+
+        Geometry geometry_header() {
+            need(1);
+            char order = data[pos++];
+            if( order!='\x00' && order!='\x01' ) fail("expected a byte order marker");
+            Geometry g;
+            g.swap = (order=='\x01')!=host_is_little_endian();
+            std::uint32_t type = read<std::uint32_t>(g.swap);
+            // EWKB flags
+            bool has_z = type & 0x80000000u;
+            bool has_m = type & 0x40000000u;
+            if( type & 0x20000000u ) read<std::uint32_t>(g.swap); // skip the SRID
+            type &= 0x0fffffffu;
+            // ISO codes: 1000s are Z, 2000s are M, 3000s are ZM
+            if( type>=1000 && type<4000 ) {
+                has_z = has_z || type/1000==1 || type/1000==3;
+                has_m = has_m || type/1000==2 || type/1000==3;
+                type %= 1000;
+            }
+            g.type = type;
+            g.dimensions = 2 + (has_z?1:0) + (has_m?1:0);
+            return g;
+        }
+
+        // Read an element count, and check that that many elements of at least
+        // min_size bytes can fit in the rest of the input (so garbage cannot make us allocate a lot)
+        std::uint32_t count( const Geometry &g, std::size_t min_size ) {
+            std::uint32_t n = read<std::uint32_t>(g.swap);
+            if( (data.size()-pos)/min_size<n ) fail("count larger than the rest of the input");
+            return n;
+        }
+
+        // At least one point, as in the WKT grammar; a ring needs three to be one
+        Points point_list( const Geometry &g, std::uint32_t min_points ) {
+            std::size_t point_size = g.dimensions*sizeof(double);
+            std::uint32_t n = count(g, point_size);
+            if( n<min_points ) fail(min_points==1 ? "expected at least one point" : "expected at least three points in a ring");
+            Points points;
+            points.reserve(n);
+            for( std::uint32_t i=0; i<n; ++i ) {
+                double x = read<double>(g.swap);
+                double y = read<double>(g.swap);
+                pos += (g.dimensions-2)*sizeof(double); // drop z and m
+                points.push_back({x,y});
+            }
+            return points;
+        }
+
+        Polygon polygon_body( const Geometry &g ) {
+            std::uint32_t n = count(g, 4);
+            if( n==0 ) fail("expected at least one ring");
+            Polygon polygon;
+            polygon.reserve(n);
+            for( std::uint32_t i=0; i<n; ++i ) polygon.push_back( point_list(g, 3) );
+            return polygon;
+        }
+
+        // Adds a polygon or the members of a multipolygon; false if it is neither
+        bool polygonal( const Geometry &g, MultiPolygon &polygons ) {
+            if( g.type==polygon_type ) {
+                polygons.push_back( polygon_body(g) );
+            } else if( g.type==multipolygon_type ) {
+                std::uint32_t n = count(g, 9);
+                if( n==0 ) fail("expected at least one polygon");
+                for( std::uint32_t i=0; i<n; ++i ) {
+                    Geometry p = geometry_header();
+                    if( p.type!=polygon_type ) fail("expected a polygon");
+                    polygons.push_back( polygon_body(p) );
+                }
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        MultiLineString multilinestring_body( const Geometry &g ) {
+            std::uint32_t n = count(g, 9);
+            MultiLineString linestrings;
+            linestrings.reserve(n);
+            for( std::uint32_t i=0; i<n; ++i ) {
+                Geometry l = geometry_header();
+                if( l.type!=linestring_type ) fail("expected a linestring");
+                linestrings.push_back( point_list(l, 1) );
+            }
+            return linestrings;
+        }
+
+        std::string_view data;
+        std::size_t pos = 0;
+    };
+
+    inline std::tuple<bool,TessaInput> parse_wkb( std::string_view wkb ) {
+        Wkb_reader reader(wkb);
+        try {
+            TessaInput input = reader.tessa_input();
+            if( reader.position()!=wkb.size() ) {
+                console->warn( "Ignoring {} bytes after the WKB geometry", wkb.size()-reader.position() );
+            }
+            return {true, input};
+        } catch( Wkb_reader::Error const& x ) {
+            console->error( "WKB parse error at byte {}: {}", x.pos, x.what );
+            return {false,{}};
+        }
+    }
+
+}
+
+#endif //ndef INCLUDED_PARSE_WKB
\ No newline at end of file
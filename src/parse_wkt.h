@@ -13,27 +13,18 @@
 #include <boost/fusion/include/adapt_struct.hpp>
 #include <boost/fusion/include/io.hpp>
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <vector>
 #include <tuple>
 #include <sstream>
+#include <string_view>
 
 #include <memory>
 #include "logging.h"
+#include "tessa_input.h"
 
-namespace parser {
-    struct Point {
-        double x, y;
-    };
-    using Points = std::vector<Point>;
-    using Polygon = std::vector<Points>;
-    using LineString = Points;
-    using MultiLineString = std::vector<LineString>;
-    //using TessaInput = std::tuple<Polygon,MultiLineString>;
-    struct TessaInput {
-        Polygon polygon;
-        MultiLineString linestrings;
-    };
-}
 BOOST_FUSION_ADAPT_STRUCT(
     parser::Point,
     (double, x),
@@ -41,7 +32,7 @@ BOOST_FUSION_ADAPT_STRUCT(
 )
 BOOST_FUSION_ADAPT_STRUCT(
     parser::TessaInput,
-    (parser::Polygon, polygon),
+    (parser::MultiPolygon, polygons),
     (parser::MultiLineString, linestrings)
 )
 namespace parser {    
@@ -50,7 +41,6 @@ namespace parser {
     namespace phoenix = boost::phoenix;
     namespace ascii = boost::spirit::ascii;
 
-    TessaInput foo(const Polygon &p) { return {p,{}}; }
 
     template<typename Iterator>
     struct wkt_grammar : qi::grammar<Iterator,TessaInput(),ascii::space_type> {
@@ -64,22 +54,37 @@ namespace parser {
             using qi::no_case;
             using phoenix::construct;
             using phoenix::val;
+            using phoenix::at_c;
+            using phoenix::push_back;
+            using phoenix::insert;
+            using phoenix::begin;
+            using phoenix::end;
             using namespace qi::labels;
 
             wkt_tessa = eps > ( wkt_geomcoll
-                              | (wkt_polygon > attr(MultiLineString()))
+                              | (wkt_polygonal > attr(MultiLineString()))
                               ); 
 
+            // any number of polygons and multipolygons, then at most one multilinestring
             wkt_geomcoll = no_case[lit("GEOMETRYCOLLECTION")] > lit('(')
-                        > wkt_polygon
-                        > -(',' > wkt_multilinestring)
+                        > (wkt_polygonal[insert(at_c<0>(_val), end(at_c<0>(_val)), begin(_1), end(_1))] % ',')
+                        > -(',' > wkt_multilinestring[at_c<1>(_val) = _1])
+                        > lit(')');
+
+            wkt_polygonal = wkt_multipolygon[_val = _1]
+                          | wkt_polygon[push_back(_val, _1)];
+
+            wkt_multipolygon = no_case[lit("MULTIPOLYGON")] > lit('(')
+                        > (polygon_body % ',')
                         > lit(')');
 
             wkt_multilinestring = no_case[lit("MULTILINESTRING")] > lit('(')
                         > (point_list % ',')
                         > lit(')');
 
-            wkt_polygon = no_case[lit("POLYGON")] > lit('(')
+            wkt_polygon = no_case[lit("POLYGON")] > polygon_body;
+
+            polygon_body = lit('(')
                         > (point_list % ',')
                         > lit(')');
 
@@ -91,14 +96,20 @@ namespace parser {
 
             point.name("point");
             point_list.name("point_list");
+            polygon_body.name("polygon_body");
             wkt_polygon.name("wkt_polygon");
+            wkt_multipolygon.name("wkt_multipolygon");
+            wkt_polygonal.name("wkt_polygon or wkt_multipolygon");
             wkt_geomcoll.name("wkt_geometrycollection");
             wkt_multilinestring.name("wkt_multilinestring");
             wkt_tessa.name("tessa input");
         }
         qi::rule<Iterator,Point(),ascii::space_type> point;
         qi::rule<Iterator,Points(),ascii::space_type> point_list;
+        qi::rule<Iterator,Polygon(),ascii::space_type> polygon_body;
         qi::rule<Iterator,Polygon(),ascii::space_type> wkt_polygon;
+        qi::rule<Iterator,MultiPolygon(),ascii::space_type> wkt_multipolygon;
+        qi::rule<Iterator,MultiPolygon(),ascii::space_type> wkt_polygonal;
         qi::rule<Iterator,TessaInput(),ascii::space_type> wkt_geomcoll;
         qi::rule<Iterator,MultiLineString(),ascii::space_type> wkt_multilinestring;
         qi::rule<Iterator,TessaInput(),ascii::space_type> wkt_tessa;
@@ -117,36 +128,142 @@ namespace parser {
             }
         }
     };
-    void print_error(int lineno, int colno, boost::spirit::info const& what) {
+    inline void print_error(int lineno, int colno, boost::spirit::info const& what) {
         using boost::spirit::basic_info_walker;
         printer pr(lineno,colno);
         basic_info_walker<printer> walker(pr, what.tag, 0);
         boost::apply_visitor(walker, what.value);
     }
 
-    // the actual parse function
-    std::tuple<bool,TessaInput> parse_wkt_polygon( std::string wkt ) {
+    // === Hand-written parser for the same grammar ===
+    // Much faster than the Spirit grammar on long coordinate lists: numbers go
+    // through std::from_chars and point vectors are reserved up front. It only
+    // says yes or no; on no, we run the Spirit grammar to report where and why.
+    // To keep those two in agreement it is conservative: anything unusual
+    // (e.g. "nan" or "inf" coordinates) is left to Spirit.
+    class Wkt_fast_parser {
+    public:
+        explicit Wkt_fast_parser( std::string_view wkt ) : p(wkt.data()), end(wkt.data()+wkt.size()) {}
+
+        bool tessa_input( TessaInput &input ) {
+            if( keyword("GEOMETRYCOLLECTION") ) {
+                if( !symbol('(') || !polygonal(input.polygons) ) return false;
+                while( symbol(',') ) {
+                    if( keyword("MULTILINESTRING") ) {
+                        if( !point_lists(input.linestrings) ) return false;
+                        break;
+                    }
+                    if( !polygonal(input.polygons) ) return false;
+                }
+                return symbol(')');
+            }
+            return polygonal(input.polygons);
+            // like the Spirit version, we don't care what comes after
+        }
+
+    private:
+        static bool is_space( char c ) {
+            return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\v' || c=='\f';
+        }
+        void skip() {
+            while( p<end && is_space(*p) ) ++p;
+        }
+        bool symbol( char c ) {
+            skip();
+            if( p==end || *p!=c ) return false;
+            ++p;
+            return true;
+        }
+        // case insensitive; kw is in upper case
+        bool keyword( std::string_view kw ) {
+            skip();
+            if( static_cast<std::size_t>(end-p)<kw.size() ) return false;
+            for( std::size_t i=0; i<kw.size(); ++i ) {
+                char c = p[i];
+                if( c>='a' && c<='z' ) c = c-'a'+'A';
+                if( c!=kw[i] ) return false;
+            }
+            p += kw.size();
+            return true;
+        }
+        bool number( double &x ) {
+            skip();
+            if( p<end && *p=='+' ) { // from_chars does not take a plus sign
+                ++p;
+                if( p<end && *p=='-' ) return false; // "+-5": Spirit rejects it, so do we
+            }
+            const char *digits = (p<end && *p=='-') ? p+1 : p;
+            if( digits==end || !((*digits>='0' && *digits<='9') || *digits=='.') ) return false;
+            auto result = std::from_chars(p, end, x);
+            if( result.ec!=std::errc() ) return false;
+            p = result.ptr;
+            return true;
+        }
+        bool point_list( Points &points ) {
+            if( !symbol('(') ) return false;
+            // one more point than there are commas before the closing parenthesis
+            const char *close = static_cast<const char*>( std::memchr(p, ')', end-p) );
+            if( close ) points.reserve( std::count(p, close, ',')+1 );
+            do {
+                Point point;
+                if( !number(point.x) || !number(point.y) ) return false;
+                points.push_back(point);
+            } while( symbol(',') );
+            return symbol(')');
+        }
+        bool point_lists( std::vector<Points> &lists ) {
+            if( !symbol('(') ) return false;
+            do {
+                lists.emplace_back();
+                if( !point_list(lists.back()) ) return false;
+            } while( symbol(',') );
+            return symbol(')');
+        }
+        // a polygon or a multipolygon, added to polygons
+        bool polygonal( MultiPolygon &polygons ) {
+            if( keyword("POLYGON") ) {
+                polygons.emplace_back();
+                return point_lists(polygons.back());
+            }
+            if( !keyword("MULTIPOLYGON") || !symbol('(') ) return false;
+            do {
+                polygons.emplace_back();
+                if( !point_lists(polygons.back()) ) return false;
+            } while( symbol(',') );
+            return symbol(')');
+        }
+
+        const char *p;
+        const char *end;
+    };
+
+    inline bool parse_wkt_fast( std::string_view wkt, TessaInput &input ) {
+        return Wkt_fast_parser(wkt).tessa_input(input);
+    }
+
+    // the Spirit parser; reports errors with line and column
+    inline std::tuple<bool,TessaInput> parse_wkt_spirit( std::string_view wkt ) {
         TessaInput input;
         // run parser
-        using It = boost::spirit::line_pos_iterator<std::string::const_iterator>;
+        using It = boost::spirit::line_pos_iterator<const char*>;
         wkt_grammar<It> grammar;
-        It begin( wkt.begin() );
-        It end( wkt.end() );
+        It begin( wkt.data() );
+        It end( wkt.data()+wkt.size() );
         try {
             // success
             bool success = qi::phrase_parse(begin, end, grammar, ascii::space, input);
             return {success, input};
         } catch (qi::expectation_failure<It> const& x) {
             // fail; print error message
-            It lower_bound(wkt.begin());
-            It upper_bound(wkt.end());
+            It lower_bound( wkt.data() );
+            It upper_bound( wkt.data()+wkt.size() );
             int lineno = boost::spirit::get_line(x.first);
             int colno = boost::spirit::get_column(lower_bound,x.first);
             print_error(lineno,colno,x.what_);
             auto lineit = boost::spirit::get_current_line(lower_bound,x.first,upper_bound);
             std::string line{lineit.begin(),lineit.end()};
             console->error( line );
-            stringstream indicator;
+            std::stringstream indicator;
             for( int i=1; i<colno; ++i ) indicator << "-";
             indicator << "^";
             console->error( indicator.str() );
@@ -155,6 +272,14 @@ namespace parser {
         // pray for RVO
     }
 
+    // the actual parse function; parses straight from the given bytes, without copying
+    inline std::tuple<bool,TessaInput> parse_wkt_polygon( std::string_view wkt ) {
+        TessaInput input;
+        if( parse_wkt_fast(wkt, input) ) return {true, std::move(input)};
+        // something's wrong; let Spirit find out what
+        return parse_wkt_spirit(wkt);
+    }
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Process wide counters for --stats; see stats.h. Allocations are counted by
+// replacing the global operator new. The other forms of new (arrays, nothrow)
+// end up here, and the default operator delete frees what malloc gave us.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "stats.h"
+
+static std::atomic<std::size_t> num_allocations{0};
+
+void *operator new( std::size_t size ) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if( size==0 ) size = 1;
+    while( true ) {
+        if( void *p = std::malloc(size) ) return p;
+        std::new_handler handler = std::get_new_handler();
+        if( !handler ) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete( void *p ) noexcept {
+    std::free(p);
+}
+
+void operator delete( void *p, std::size_t ) noexcept {
+    std::free(p);
+}
+
+std::size_t allocation_count() {
+    return num_allocations.load(std::memory_order_relaxed);
+}
+
+std::size_t peak_rss_bytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if( !GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ) return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage;
+    if( getrusage(RUSAGE_SELF, &usage)!=0 ) return 0;
+#ifdef __APPLE__
+    return static_cast<std::size_t>(usage.ru_maxrss);      // bytes
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss)*1024; // kilobytes
+#endif
+#endif
+}
\ No newline at end of file
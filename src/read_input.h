@@ -0,0 +1,62 @@
+#ifndef INCLUDED_READ_INPUT
+#define INCLUDED_READ_INPUT
+
+#include <filesystem>
+#include <istream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "logging.h"
+
+// === The bytes of the input ===
+// Files are memory-mapped, so the parsers read straight from the page cache
+// without copying; streams (stdin) are read into a buffer in one go.
+
+class Input_data {
+public:
+    // Returns false if the file cannot be read
+    bool open_file( const std::string &fname ) {
+        namespace bip = boost::interprocess;
+        try {
+            if( std::filesystem::file_size(fname)==0 ) { // cannot map an empty file
+                data = {};
+                return true;
+            }
+            file = bip::file_mapping( fname.c_str(), bip::read_only );
+            region = bip::mapped_region( file, bip::read_only );
+            region.advise( bip::mapped_region::advice_sequential );
+            data = std::string_view( static_cast<const char*>(region.get_address()), region.get_size() );
+            return true;
+        } catch( std::exception &x ) {
+            console->error( "Cannot read {}: {}", fname, x.what() );
+            return false;
+        }
+    }
+
+    void read_stream( std::istream &in ) {
+        buffer.assign( std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() );
+        data = buffer;
+    }
+
+    std::string_view view() const { return data; }
+
+    // Unmap the file, or free the buffer; view() is empty after this
+    void release() {
+        region = boost::interprocess::mapped_region();
+        file = boost::interprocess::file_mapping();
+        std::string().swap(buffer);
+        data = {};
+    }
+
+private:
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+    std::string buffer;
+    std::string_view data;
+};
+
+#endif //ndef INCLUDED_READ_INPUT
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef INCLUDED_REORDER
+#define INCLUDED_REORDER
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "tessa_mesh.h"
+
+// === Spatially coherent numbering (--reorder) ===
+// Without it, input vertices come first, in input order, and then the
+// vertices refinement added, in whatever order the triangulation holds them;
+// edges come in triangulation order. Reordering numbers the vertices along a
+// space-filling curve (Hilbert or Morton/Z-order) through their coordinates,
+// so vertices close together get ids close together, and sorts the edges by
+// (smaller id, larger id), with the smaller id first.
+
+namespace reorder {
+
+    const int bits = 21; // per axis; the keys fit in 42 bits
+
+    // Position of cell (x,y) along the Hilbert curve through a 2^bits by 2^bits grid
+    inline std::uint64_t hilbert_key( std::uint32_t x, std::uint32_t y ) {
+        std::uint64_t key = 0;
+        for( std::uint32_t s = std::uint32_t(1)<<(bits-1); s>0; s>>=1 ) {
+            std::uint32_t rx = (x & s) ? 1 : 0, ry = (y & s) ? 1 : 0;
+            key += std::uint64_t(s)*s*((3*rx)^ry);
+            // rotate the quadrant, so that the curve inside it runs the right way
+            if( ry==0 ) {
+                if( rx==1 ) {
+                    x = s-1 - (x & (s-1));
+                    y = s-1 - (y & (s-1));
+                }
+                std::swap(x, y);
+            }
+        }
+        return key;
+    }
+
+    // Interleaved bits of x and y
+    inline std::uint64_t morton_key( std::uint32_t x, std::uint32_t y ) {
+        auto spread = []( std::uint64_t v ) {
+            v &= (std::uint64_t(1)<<bits)-1;
+            v = (v | (v<<16)) & 0x0000FFFF0000FFFFull;
+            v = (v | (v<<8))  & 0x00FF00FF00FF00FFull;
+            v = (v | (v<<4))  & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | (v<<2))  & 0x3333333333333333ull;
+            v = (v | (v<<1))  & 0x5555555555555555ull;
+            return v;
+        };
+        return spread(x) | (spread(y)<<1);
+    }
+
+    // Renumber the vertices of mesh along the curve ("hilbert" or "morton")
+    // and sort its edges. Returns, for every new id, the id the vertex had
+    // before, so that input vertices can still be found.
+    inline std::vector<int> reorder_mesh( Tessa_mesh &mesh, const std::string &curve ) {
+        const std::size_t n = mesh.num_vertices(), m = mesh.num_edges();
+        std::vector<int> old_id(n);
+        std::iota( old_id.begin(), old_id.end(), 0 );
+        if( n==0 ) return old_id;
+
+        // Grid cells over the bounding box
+        double xmin = mesh.coordinates[0], xmax = xmin, ymin = mesh.coordinates[1], ymax = ymin;
+        for( std::size_t i=1; i<n; ++i ) {
+            xmin = std::min(xmin, mesh.coordinates[2*i]); xmax = std::max(xmax, mesh.coordinates[2*i]);
+            ymin = std::min(ymin, mesh.coordinates[2*i+1]); ymax = std::max(ymax, mesh.coordinates[2*i+1]);
+        }
+        const double cells = double((std::uint32_t(1)<<bits)-1);
+        const double extent = std::max(xmax-xmin, ymax-ymin);
+        const double scale = extent>0 ? cells/extent : 0;
+        std::vector<std::uint64_t> keys(n);
+        const bool hilbert = curve!="morton";
+        for( std::size_t i=0; i<n; ++i ) {
+            auto x = static_cast<std::uint32_t>( std::min(cells, (mesh.coordinates[2*i]-xmin)*scale) );
+            auto y = static_cast<std::uint32_t>( std::min(cells, (mesh.coordinates[2*i+1]-ymin)*scale) );
+            keys[i] = hilbert ? hilbert_key(x, y) : morton_key(x, y);
+        }
+        std::stable_sort( old_id.begin(), old_id.end(), [&]( int a, int b ) { return keys[a]<keys[b]; } );
+
+        std::vector<int> new_id(n);
+        std::vector<double> coordinates(2*n);
+        for( std::size_t i=0; i<n; ++i ) {
+            new_id[old_id[i]] = static_cast<int>(i);
+            coordinates[2*i] = mesh.coordinates[2*old_id[i]];
+            coordinates[2*i+1] = mesh.coordinates[2*old_id[i]+1];
+        }
+        mesh.coordinates.swap(coordinates);
+
+        // Edges, renumbered, smaller id first, sorted
+        std::vector<std::uint64_t> edge_keys(m);
+        for( std::size_t j=0; j<m; ++j ) {
+            std::uint64_t a = new_id[mesh.edge_vertices[2*j]], b = new_id[mesh.edge_vertices[2*j+1]];
+            edge_keys[j] = std::min(a,b)<<32 | std::max(a,b);
+        }
+        std::vector<std::size_t> order(m);
+        std::iota( order.begin(), order.end(), 0 );
+        std::sort( order.begin(), order.end(), [&]( std::size_t a, std::size_t b ) { return edge_keys[a]<edge_keys[b]; } );
+        std::vector<int> edge_vertices(2*m);
+        std::vector<double> edge_lengths(m);
+        std::vector<unsigned char> edge_types(m);
+        for( std::size_t k=0; k<m; ++k ) {
+            std::size_t j = order[k];
+            edge_vertices[2*k] = static_cast<int>(edge_keys[j]>>32);
+            edge_vertices[2*k+1] = static_cast<int>(edge_keys[j] & 0xFFFFFFFFull);
+            edge_lengths[k] = mesh.edge_lengths[j];
+            edge_types[k] = mesh.edge_types[j];
+        }
+        mesh.edge_vertices.swap(edge_vertices);
+        mesh.edge_lengths.swap(edge_lengths);
+        mesh.edge_types.swap(edge_types);
+        return old_id;
+    }
+
+}
+
+#endif //ndef INCLUDED_REORDER
\ No newline at end of file
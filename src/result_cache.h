@@ -0,0 +1,172 @@
+#ifndef INCLUDED_RESULT_CACHE
+#define INCLUDED_RESULT_CACHE
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "logging.h"
+#include "tessa.h"
+#include "tessa_input.h"
+
+// === Results on disk (--cache-dir) ===
+// The output for an input is stored under a hash of the parsed input and of
+// every option that changes the output, so inputs that did not change since
+// the last run are not tessellated again. Hashing the parsed geometry means
+// that the same polygon in WKT or WKB, or formatted differently, hits too.
+// An entry is a line "tessa_cache <version> <result>" followed by the output
+// bytes. Entries are written to a temporary file in the same directory and
+// renamed into place, so concurrent processes sharing the directory only
+// ever see complete entries; when two write the same entry, the last rename
+// wins, and both wrote the same bytes.
+// Results with a time limit are not cached: they depend on the machine.
+// A vertex limit is fine, as the result does not depend on the number of
+// jobs then (see Budget in tessa.cpp), which is not in the key.
+// Coordinates are hashed bit for bit: -0 is written as -0.
+
+class Result_cache {
+public:
+    static constexpr int format_version = 2;
+
+    // False (with a logged error) if the directory cannot be made
+    bool open( const std::string &directory ) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if( error ) {
+            console->error("Cannot use cache directory {}: {}", directory, error.message());
+            return false;
+        }
+        dir = directory;
+        return true;
+    }
+
+    // Can this run use the cache at all?
+    static bool cacheable( const Tessa_options &options ) { return options.time_limit==0; }
+
+    // 32 hex digits: two independent 64-bit hashes of the input and the options
+    static std::string key( const parser::TessaInput &input, const Tessa_options &options, const std::string &format ) {
+        Hasher h;
+        h.add( std::string(tessa_version) );
+        h.add( std::uint64_t(format_version) );
+        h.add( format );
+        h.add( std::uint64_t(options.make_cdt) );
+        h.add( std::uint64_t(options.make_mesh) );
+        h.add( std::uint64_t(options.make_gabriel) );
+        h.add( options.meshing_param_B );
+        h.add( options.meshing_param_S );
+        h.add( options.free_for );
+        h.add( options.reorder );
+        h.add( options.repair_method );
+        h.add( options.kernel );
+        h.add( std::uint64_t(options.tiles) );
+        h.add( std::uint64_t(options.max_vertices) );
+        h.add( options.snap );
+        h.add( options.simplify );
+        h.add( options.validate );
+        h.add( std::uint64_t(options.lean) ); // edge lengths may differ in the last digit
+
+        auto add_chain = [&]( const parser::Points &chain ) {
+            h.add( std::uint64_t(chain.size()) );
+            for( auto &p : chain ) {
+                h.add(p.x);
+                h.add(p.y);
+            }
+        };
+        h.add( std::uint64_t(input.polygons.size()) );
+        for( auto &polygon : input.polygons ) {
+            h.add( std::uint64_t(polygon.size()) );
+            for( auto &ring : polygon ) add_chain(ring);
+        }
+        h.add( std::uint64_t(input.linestrings.size()) );
+        for( auto &linestring : input.linestrings ) add_chain(linestring);
+
+        char hex[33];
+        std::snprintf( hex, sizeof(hex), "%016llx%016llx", (unsigned long long)h.a, (unsigned long long)h.b );
+        return hex;
+    }
+
+    // On a hit, copy the stored output to out, set result to the stored
+    // result (0 or tessa_partial), and return true
+    bool fetch( const std::string &key, int &result, std::ostream &out ) const {
+        std::ifstream in( path(key), std::ios::in|std::ios::binary );
+        if( !in ) return false;
+        std::string word;
+        int version = 0;
+        in >> word >> version >> result;
+        if( !in || word!="tessa_cache" || version!=format_version || in.get()!='\n' ) {
+            console->warn("Ignoring bad cache entry {}", path(key).string());
+            return false;
+        }
+        if( in.peek()!=std::ifstream::traits_type::eof() ) out << in.rdbuf();
+        return true;
+    }
+
+    // Store an output; failures are logged, and otherwise ignored
+    void store( const std::string &key, int result, std::string_view output ) const {
+        if( result!=0 && result!=tessa_partial ) return;
+        std::filesystem::path target = path(key);
+        std::filesystem::path tmp = target;
+        tmp += "." + unique_suffix() + ".tmp";
+        {
+            std::ofstream os( tmp, std::ios::out|std::ios::binary );
+            os << "tessa_cache " << format_version << ' ' << result << '\n';
+            os.write( output.data(), output.size() );
+            os.close();
+            if( os ) {
+                std::error_code error;
+                std::filesystem::rename(tmp, target, error);
+                if( !error ) return;
+            }
+        }
+        console->warn("Cannot write cache entry {}", target.string());
+        std::error_code ignored;
+        std::filesystem::remove(tmp, ignored);
+    }
+
+private:
+    // FNV-1a over the bytes, and a splitmix64 chain over the 64-bit words
+    struct Hasher {
+        std::uint64_t a = 0xcbf29ce484222325ull, b = 0x9e3779b97f4a7c15ull;
+
+        void add( std::uint64_t w ) {
+            for( int i=0; i<8; ++i ) {
+                a ^= (w>>(8*i)) & 0xff;
+                a *= 0x100000001b3ull;
+            }
+            b += w + 0x9e3779b97f4a7c15ull;
+            std::uint64_t z = b;
+            z = (z ^ (z>>30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z>>27)) * 0x94d049bb133111ebull;
+            b = z ^ (z>>31);
+        }
+        void add( double d ) {
+            std::uint64_t w;
+            std::memcpy( &w, &d, sizeof(w) );
+            add(w);
+        }
+        void add( const std::string &s ) {
+            add( std::uint64_t(s.size()) );
+            for( unsigned char c : s ) add( std::uint64_t(c) );
+        }
+    };
+
+    std::filesystem::path path( const std::string &key ) const { return std::filesystem::path(dir) / (key + ".tessa"); }
+
+    static std::string unique_suffix() {
+        std::random_device device;
+        std::uint64_t r = (std::uint64_t(device())<<32) ^ device();
+        char hex[17];
+        std::snprintf( hex, sizeof(hex), "%016llx", (unsigned long long)r );
+        return hex;
+    }
+
+    std::string dir;
+};
+
+#endif //ndef INCLUDED_RESULT_CACHE
\ No newline at end of file
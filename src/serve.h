@@ -0,0 +1,162 @@
+#ifndef INCLUDED_SERVE
+#define INCLUDED_SERVE
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "logging.h"
+
+// === Server mode ===
+// Requests and responses are frames: a decimal byte count, a newline, and
+// that many bytes. A request holds a line of options, written as on the
+// command line (e.g. "--mesh --B 0.1"), a newline, and the input as WKT or
+// WKB. A response holds "ok" and a newline followed by the output in text
+// format, or just "error" and a newline. With --max-vertices or --time-limit,
+// it may start with "partial" instead of "ok"; see tessa_partial in tessa.h.
+// Frames come in on stdin and go out on stdout, or over a Unix domain socket,
+// with a thread per connection. POSIX only.
+
+namespace serve {
+
+    const std::uint64_t max_frame_size = 0xffffffffu; // what a 32-bit size_t can hold
+
+    // Buffered reads from a file descriptor
+    class Frame_reader {
+    public:
+        explicit Frame_reader( int fd ) : fd(fd) {}
+
+        // Reads one frame; false at the end of the input or on a malformed frame
+        bool read_frame( std::string &frame ) {
+            std::uint64_t size = 0;
+            int digits = 0;
+            for( char c; get(c) && c!='\n'; ++digits ) {
+                if( c<'0' || c>'9' || digits>10 ) {
+                    console->error("Malformed frame header");
+                    return false;
+                }
+                size = 10*size + (c-'0');
+            }
+            if( digits==0 ) return false; // end of input
+            if( size>max_frame_size ) {
+                console->error("Frame of {} bytes is too large", size);
+                return false;
+            }
+            std::size_t length = static_cast<std::size_t>(size);
+            frame.resize(length);
+            std::size_t have = std::min(length, end-begin);
+            std::memcpy(&frame[0], buffer+begin, have);
+            begin += have;
+            if( !read_exact(&frame[0]+have, length-have) ) {
+                console->error("Input ended in the middle of a frame");
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        bool get( char &c ) {
+            if( begin==end ) {
+                ssize_t n;
+                do n = ::read(fd, buffer, sizeof(buffer)); while( n<0 && errno==EINTR );
+                if( n<=0 ) return false;
+                begin = 0;
+                end = n;
+            }
+            c = buffer[begin++];
+            return true;
+        }
+        bool read_exact( char *data, std::size_t size ) {
+            while( size>0 ) {
+                ssize_t n = ::read(fd, data, size);
+                if( n<0 && errno==EINTR ) continue;
+                if( n<=0 ) return false;
+                data += n;
+                size -= n;
+            }
+            return true;
+        }
+
+        int fd;
+        char buffer[1<<16];
+        std::size_t begin = 0, end = 0;
+    };
+
+    inline bool write_all( int fd, const char *data, std::size_t size ) {
+        while( size>0 ) {
+            ssize_t n = ::write(fd, data, size);
+            if( n<0 && errno==EINTR ) continue;
+            if( n<=0 ) return false;
+            data += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    inline bool write_frame( int fd, std::string_view frame ) {
+        std::string header = std::to_string(frame.size()) + '\n';
+        return write_all(fd, header.data(), header.size()) && write_all(fd, frame.data(), frame.size());
+    }
+
+    // Answer requests from in on out until the input ends;
+    // handle(std::string_view request) returns the response
+    template<typename Handler>
+    void serve_fd( int in, int out, Handler handle ) {
+        Frame_reader reader(in);
+        std::string request;
+        while( reader.read_frame(request) ) {
+            if( !write_frame(out, handle(std::string_view(request))) ) {
+                console->error("Cannot write response: {}", std::strerror(errno));
+                return;
+            }
+        }
+    }
+
+    // Listen on a Unix domain socket, forever; returns only on errors
+    template<typename Handler>
+    int serve_socket( const std::string &path, Handler handle ) {
+        std::signal(SIGPIPE, SIG_IGN); // a client hanging up is not our problem
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if( path.size()>=sizeof(address.sun_path) ) {
+            console->error("Socket path {} is too long", path);
+            return 2;
+        }
+        std::strcpy(address.sun_path, path.c_str());
+        int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        ::unlink(path.c_str()); // left over from an earlier run
+        if( listener<0
+         || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address))<0
+         || ::listen(listener, 64)<0 ) {
+            console->error("Cannot listen on {}: {}", path, std::strerror(errno));
+            return 2;
+        }
+        console->info("Listening on {}", path);
+        while( true ) {
+            int connection = ::accept(listener, nullptr, nullptr);
+            if( connection<0 ) {
+                if( errno==EINTR || errno==ECONNABORTED ) continue;
+                console->error("Cannot accept: {}", std::strerror(errno));
+                ::close(listener);
+                return 2;
+            }
+            // The thread has its own copy of handle, for state kept per connection
+            std::thread( [connection,handle]() mutable {
+                serve_fd(connection, connection, handle);
+                ::close(connection);
+            }).detach();
+        }
+    }
+
+}
+
+#endif //ndef INCLUDED_SERVE
\ No newline at end of file
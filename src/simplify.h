@@ -0,0 +1,251 @@
+#ifndef INCLUDED_SIMPLIFY
+#define INCLUDED_SIMPLIFY
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include "tessa_input.h"
+#include "tiles.h"
+
+// === Simplifying the input (--simplify) ===
+// Douglas-Peucker on every ring and linestring, keeping the topology: a run
+// of points is only replaced by a shortcut if the shortcut comes near no
+// other segment (of any chain, including its own), and no other vertex lies
+// between the run and the shortcut. So no new intersections appear, and
+// nothing changes sides. Points that several chains share (roads ending on a
+// ring, say) and the ends of linestrings always stay, and rings keep at least
+// three points.
+// Everything is in doubles; the tests err on the side of keeping points
+// whenever something comes within a few ulps of the shortcut.
+
+namespace simplify {
+
+    typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> Box_point;
+    typedef boost::geometry::model::box<Box_point>                                   Box;
+
+    // Segment from point a to point b of a chain, or point a of a chain (b unused)
+    struct Ref {
+        std::uint32_t chain, a, b;
+        bool operator==( const Ref &o ) const { return chain==o.chain && a==o.a && b==o.b; }
+    };
+    typedef std::pair<Box, Ref>                                                          Segment_value;
+    typedef std::pair<Box_point, Ref>                                                    Point_value;
+    typedef boost::geometry::index::rtree<Segment_value, boost::geometry::index::quadratic<16>> Segment_tree;
+    typedef boost::geometry::index::rtree<Point_value, boost::geometry::index::quadratic<16>>   Point_tree;
+
+    inline bool same( parser::Point p, parser::Point q ) { return p.x==q.x && p.y==q.y; }
+
+    inline double cross( parser::Point a, parser::Point b, parser::Point c ) {
+        return (b.x-a.x)*(c.y-a.y) - (b.y-a.y)*(c.x-a.x);
+    }
+
+    inline double distance_to_segment( parser::Point p, parser::Point a, parser::Point b ) {
+        double dx = b.x-a.x, dy = b.y-a.y, len2 = dx*dx+dy*dy;
+        double t = len2>0 ? std::clamp( ((p.x-a.x)*dx + (p.y-a.y)*dy)/len2, 0.0, 1.0 ) : 0.0;
+        return std::hypot( p.x-(a.x+t*dx), p.y-(a.y+t*dy) );
+    }
+
+    // Do segments ab and cd cross or come within eps of each other?
+    inline bool too_close( parser::Point a, parser::Point b, parser::Point c, parser::Point d, double eps ) {
+        double o1 = cross(a,b,c), o2 = cross(a,b,d), o3 = cross(c,d,a), o4 = cross(c,d,b);
+        if( ((o1<0 && o2>0) || (o1>0 && o2<0)) && ((o3<0 && o4>0) || (o3>0 && o4<0)) ) return true;
+        return distance_to_segment(c,a,b)<eps || distance_to_segment(d,a,b)<eps
+            || distance_to_segment(a,c,d)<eps || distance_to_segment(b,c,d)<eps;
+    }
+
+    inline Box box_of( parser::Point a, parser::Point b, double margin ) {
+        return Box( Box_point(std::min(a.x,b.x)-margin, std::min(a.y,b.y)-margin),
+                    Box_point(std::max(a.x,b.x)+margin, std::max(a.y,b.y)+margin) );
+    }
+
+    class Simplifier {
+    public:
+        Simplifier( parser::TessaInput &input, double tolerance ) : tolerance(tolerance) {
+            for( auto &polygon : input.polygons ) {
+                for( auto &ring : polygon ) add_chain( ring, true );
+            }
+            for( auto &linestring : input.linestrings ) add_chain( linestring, false );
+
+            // Points in more than one place (not counting the closing point of a ring) are pinned
+            std::unordered_map<Coordinates,int,Coordinates_hash> uses;
+            double largest = 0;
+            for( std::size_t c=0; c<chains.size(); ++c ) {
+                for( std::size_t i=0; i<distinct(c); ++i ) {
+                    parser::Point p = (*chains[c])[i];
+                    ++uses[{p.x,p.y}];
+                    largest = std::max({ largest, std::abs(p.x), std::abs(p.y) });
+                }
+            }
+            eps = std::max( 1e-6*tolerance, 64*DBL_EPSILON*largest );
+
+            std::vector<Segment_value> segments;
+            std::vector<Point_value> points;
+            for( std::size_t c=0; c<chains.size(); ++c ) {
+                const parser::Points &chain = *chains[c];
+                keep[c].assign( chain.size(), 1 );
+                pinned[c].assign( chain.size(), 0 );
+                for( std::size_t i=0; i<chain.size(); ++i ) {
+                    if( i<distinct(c) ) {
+                        points.emplace_back( Box_point(chain[i].x, chain[i].y), Ref{uint32(c), uint32(i), 0} );
+                        pinned[c][i] = uses[{chain[i].x,chain[i].y}]>1;
+                    }
+                    if( i+1<chain.size() ) segments.emplace_back( box_of(chain[i], chain[i+1], 0), Ref{uint32(c), uint32(i), uint32(i+1)} );
+                }
+            }
+            segment_tree = Segment_tree(segments); // bulk loading
+            point_tree = Point_tree(points);
+        }
+
+        // Simplify every chain and write back the result; returns the number of points removed
+        std::size_t run() {
+            std::size_t removed = 0;
+            for( std::size_t c=0; c<chains.size(); ++c ) {
+                parser::Points &chain = *chains[c];
+                if( distinct(c)<(is_ring[c] ? 4u : 3u) ) continue; // nothing to gain, or a degenerate ring
+
+                // Anchors always stay: the ends, pinned points, and for a ring two more points
+                std::vector<std::size_t> anchors{ 0, chain.size()-1 };
+                if( is_ring[c] ) {
+                    anchors.push_back( distinct(c)/3 );
+                    anchors.push_back( 2*distinct(c)/3 );
+                }
+                for( std::size_t i=1; i+1<chain.size(); ++i ) {
+                    if( pinned[c][i] ) anchors.push_back(i);
+                }
+                std::sort( anchors.begin(), anchors.end() );
+                anchors.erase( std::unique(anchors.begin(), anchors.end()), anchors.end() );
+
+                // Douglas-Peucker, with a stack instead of recursion
+                std::vector<std::pair<std::size_t,std::size_t>> stack;
+                for( std::size_t k=0; k+1<anchors.size(); ++k ) stack.emplace_back( anchors[k], anchors[k+1] );
+                while( !stack.empty() ) {
+                    auto [i,j] = stack.back();
+                    stack.pop_back();
+                    if( j-i<2 ) continue;
+                    std::size_t farthest = i+1;
+                    double distance = -1;
+                    for( std::size_t k=i+1; k<j; ++k ) {
+                        double d = distance_to_segment( chain[k], chain[i], chain[j] );
+                        if( d>distance ) { distance = d; farthest = k; }
+                    }
+                    if( distance<=tolerance && is_safe(c, i, j) ) {
+                        replace(c, i, j);
+                        removed += j-i-1;
+                    } else {
+                        stack.emplace_back( farthest, j );
+                        stack.emplace_back( i, farthest );
+                    }
+                }
+
+                std::size_t kept = 0;
+                for( std::size_t i=0; i<chain.size(); ++i ) {
+                    if( keep[c][i] ) chain[kept++] = chain[i];
+                }
+                chain.resize(kept);
+            }
+            return removed;
+        }
+
+    private:
+        static std::uint32_t uint32( std::size_t i ) { return static_cast<std::uint32_t>(i); }
+
+        void add_chain( parser::Points &chain, bool ring ) {
+            chains.push_back(&chain);
+            is_ring.push_back(ring);
+            keep.emplace_back();
+            pinned.emplace_back();
+        }
+
+        // Number of points, not counting the closing point of a ring
+        std::size_t distinct( std::size_t c ) const {
+            std::size_t n = chains[c]->size();
+            return is_ring[c] && n>0 && same((*chains[c])[0], (*chains[c])[n-1]) ? n-1 : n;
+        }
+
+        // May points i+1..j-1 of chain c go?
+        bool is_safe( std::size_t c, std::size_t i, std::size_t j ) const {
+            const parser::Points &chain = *chains[c];
+            parser::Point a = chain[i], b = chain[j];
+            if( same(a,b) ) return false; // would collapse a loop
+
+            // The shortcut must keep clear of every other segment
+            for( auto it = segment_tree.qbegin(boost::geometry::index::intersects(box_of(a, b, eps))); it!=segment_tree.qend(); ++it ) {
+                Ref s = it->second;
+                if( s.chain==c && i<=s.a && s.b<=j ) continue; // part of the run
+                parser::Point p = (*chains[s.chain])[s.a], q = (*chains[s.chain])[s.b];
+                bool shares_a = same(p,a) || same(q,a), shares_b = same(p,b) || same(q,b);
+                if( shares_a && shares_b ) return false;
+                if( shares_a || shares_b ) {
+                    // neighbours meet at the shared end; they must not overlap
+                    parser::Point shared = shares_a ? a : b, other = same(p,shared) ? q : p, own = shares_a ? b : a;
+                    if( distance_to_segment(other, a, b)<eps || distance_to_segment(own, p, q)<eps ) return false;
+                } else if( too_close(a, b, p, q, eps) ) {
+                    return false;
+                }
+            }
+
+            // No vertex may lie between the run and the shortcut: an odd number
+            // of crossings with the closed curve, or close to it. All of that
+            // is within tolerance of the shortcut.
+            for( auto it = point_tree.qbegin(boost::geometry::index::intersects(box_of(a, b, tolerance+eps))); it!=point_tree.qend(); ++it ) {
+                Ref r = it->second;
+                if( r.chain==c && i<=r.a && r.a<=j ) continue;
+                parser::Point q = (*chains[r.chain])[r.a];
+                if( same(q,a) || same(q,b) ) continue;
+                if( distance_to_segment(q, a, b)>tolerance+eps ) continue;
+                if( distance_to_segment(q, a, b)<eps ) return false;
+                bool inside = false;
+                for( std::size_t k=i; k<=j; ++k ) {
+                    parser::Point u = chain[k], v = k<j ? chain[k+1] : a; // the run, then back along the shortcut
+                    if( distance_to_segment(q, u, v)<eps ) return false;
+                    bool up = u.y<=q.y && v.y>q.y, down = v.y<=q.y && u.y>q.y;
+                    if( (up && cross(u,v,q)>0) || (down && cross(u,v,q)<0) ) inside = !inside;
+                }
+                if( inside ) return false;
+            }
+            return true;
+        }
+
+        // Replace points i..j of chain c by the segment from i to j
+        void replace( std::size_t c, std::size_t i, std::size_t j ) {
+            const parser::Points &chain = *chains[c];
+            for( std::size_t k=i; k<j; ++k ) {
+                segment_tree.remove( Segment_value(box_of(chain[k], chain[k+1], 0), Ref{uint32(c), uint32(k), uint32(k+1)}) );
+                if( k>i ) {
+                    point_tree.remove( Point_value(Box_point(chain[k].x, chain[k].y), Ref{uint32(c), uint32(k), 0}) );
+                    keep[c][k] = 0;
+                }
+            }
+            segment_tree.insert( Segment_value(box_of(chain[i], chain[j], 0), Ref{uint32(c), uint32(i), uint32(j)}) );
+        }
+
+        double tolerance, eps = 0;
+        std::vector<parser::Points*> chains;
+        std::vector<bool> is_ring;
+        std::vector<std::vector<char>> keep, pinned;
+        Segment_tree segment_tree;
+        Point_tree point_tree;
+    };
+
+    // Simplify all rings and linestrings in place, with the given tolerance
+    // (the largest distance of a removed point to what replaces it). Returns
+    // the number of points removed.
+    inline std::size_t simplify( parser::TessaInput &input, double tolerance ) {
+        if( !(tolerance>0) ) return 0;
+        return Simplifier(input, tolerance).run();
+    }
+
+}
+
+#endif //ndef INCLUDED_SIMPLIFY
\ No newline at end of file
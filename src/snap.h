@@ -0,0 +1,143 @@
+#ifndef INCLUDED_SNAP
+#define INCLUDED_SNAP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tessa_input.h"
+#include "tiles.h"
+
+// === Snapping near-coincident points (--snap) ===
+// Points closer than epsilon to each other, in any chain, are merged: going
+// through the input in order, every point moves to the nearest earlier
+// point within epsilon, if there is one, found through a hashed grid with
+// cells of size epsilon. Merging makes consecutive points of a chain equal;
+// those zero-length segments go. Rings left with fewer than three distinct
+// points go too (for an outer ring: the whole polygon), as do linestrings
+// left with a single point. No point moves by epsilon or more, but a moved
+// point may end up on the other side of a chain that passed between it and
+// its new place, when epsilon is larger than the features of the input.
+// Equal points always snap to the same place, so rings stay closed and
+// shared points stay shared.
+
+namespace snap {
+
+    // The smallest epsilon taken (besides 0, for no snapping): below it, the
+    // grid has more cells than a 64-bit index counts for ordinary coordinates
+    const double min_epsilon = 1e-9;
+    inline bool usable_epsilon( double epsilon ) { return epsilon==0 || (std::isfinite(epsilon) && epsilon>=min_epsilon); }
+
+    struct Snap_report {
+        std::size_t merged = 0;           // points moved onto another one
+        std::size_t dropped_segments = 0; // segments that became zero length
+        std::size_t dropped_chains = 0;   // rings and linestrings that collapsed
+    };
+
+    class Snap_grid {
+    public:
+        explicit Snap_grid( double epsilon ) : epsilon(epsilon) {}
+
+        // The point p snaps to: the nearest earlier point within epsilon, or p itself
+        parser::Point snap( parser::Point p ) {
+            auto seen = snapped.find({p.x,p.y});
+            if( seen!=snapped.end() ) return seen->second;
+            parser::Point q = nearest(p);
+            snapped.emplace( Coordinates{p.x,p.y}, q );
+            return q;
+        }
+
+    private:
+        parser::Point nearest( parser::Point p ) {
+            std::int64_t cx = cell(p.x), cy = cell(p.y);
+            const parser::Point *best = nullptr;
+            double best_distance = epsilon;
+            for( std::int64_t dx=-1; dx<=1; ++dx ) {
+                for( std::int64_t dy=-1; dy<=1; ++dy ) {
+                    auto found = grid.find( key(cx+dx, cy+dy) );
+                    if( found==grid.end() ) continue;
+                    for( std::uint32_t r : found->second ) {
+                        double d = std::hypot( points[r].x-p.x, points[r].y-p.y );
+                        if( d<best_distance ) {
+                            best_distance = d;
+                            best = &points[r];
+                        }
+                    }
+                }
+            }
+            if( best ) return *best;
+            grid[key(cx,cy)].push_back( static_cast<std::uint32_t>(points.size()) );
+            points.push_back(p);
+            return p;
+        }
+
+        // Clamped before the conversion, which would overflow for coordinates
+        // very much larger than epsilon; points in the outermost cells are
+        // still compared by their distance, so they only get slower
+        std::int64_t cell( double v ) const {
+            const double limit = 4e18; // below 2^62, so cell+1 fits too
+            double c = std::floor(v/epsilon);
+            return static_cast<std::int64_t>( std::max(-limit, std::min(limit, c)) );
+        }
+        static std::uint64_t key( std::int64_t cx, std::int64_t cy ) {
+            return static_cast<std::uint64_t>(cx)*0x9e3779b97f4a7c15ull ^ static_cast<std::uint64_t>(cy);
+        }
+
+        double epsilon;
+        std::vector<parser::Point> points; // the points others snap to
+        std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> grid;
+        std::unordered_map<Coordinates, parser::Point, Coordinates_hash> snapped;
+    };
+
+    inline Snap_report snap( parser::TessaInput &input, double epsilon ) {
+        Snap_report report;
+        if( !(epsilon>0) ) return report;
+        Snap_grid grid(epsilon);
+
+        // Snap a chain and drop its zero-length segments; false if it collapsed
+        auto snap_chain = [&]( parser::Points &chain, bool ring ) {
+            std::size_t kept = 0;
+            for( std::size_t i=0; i<chain.size(); ++i ) {
+                parser::Point p = grid.snap(chain[i]);
+                if( p.x!=chain[i].x || p.y!=chain[i].y ) ++report.merged;
+                if( kept>0 && p.x==chain[kept-1].x && p.y==chain[kept-1].y ) {
+                    ++report.dropped_segments;
+                    continue;
+                }
+                chain[kept++] = p;
+            }
+            chain.resize(kept);
+            return ring ? kept>=4 : kept>=2; // a ring repeats its first point
+        };
+
+        std::vector<parser::Polygon> polygons;
+        for( auto &polygon : input.polygons ) {
+            parser::Polygon snapped;
+            for( std::size_t r=0; r<polygon.size(); ++r ) {
+                if( snap_chain(polygon[r], true) ) {
+                    snapped.push_back( std::move(polygon[r]) );
+                } else {
+                    ++report.dropped_chains;
+                    if( r==0 ) break; // without its outer ring, the polygon is gone
+                }
+            }
+            if( !snapped.empty() ) polygons.push_back( std::move(snapped) );
+        }
+        input.polygons.swap(polygons);
+
+        std::vector<parser::LineString> linestrings;
+        for( auto &linestring : input.linestrings ) {
+            if( snap_chain(linestring, false) ) linestrings.push_back( std::move(linestring) );
+            else ++report.dropped_chains;
+        }
+        input.linestrings.swap(linestrings);
+        return report;
+    }
+
+}
+
+#endif //ndef INCLUDED_SNAP
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef INCLUDED_STATS
+#define INCLUDED_STATS
+
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <utility>
+
+// === Instrumentation ===
+// Time spent in each stage, and counters, for --stats. Polygons of a
+// multipolygon and batch records run on several threads and add up their
+// times, so those are thread times; tiled meshing reports wall clock times.
+// In tiled meshing, domain marking is part of refine and label_repair, and
+// id_cleanup is the stitching of the tiles.
+
+struct Tessa_stats {
+    // Milliseconds per stage
+    double read_ms = 0;             // reading the input
+    double parse_ms = 0;            // WKT or WKB to parser types
+    double snap_ms = 0;             // --snap
+    double simplify_ms = 0;         // --simplify
+    double validate_ms = 0;         // --validate
+    double insert_vertices_ms = 0;  // input points into the CDT
+    double insert_chain_ms = 0;     // input segments as constraints
+    double refine_ms = 0;           // conforming Delaunay or Gabriel, meshing
+    double domain_marking_ms = 0;
+    double label_repair_ms = 0;     // finding the input edge under each edge
+    double id_cleanup_ms = 0;       // ids for new vertices; stitching tiles
+    double collect_ms = 0;          // CDT to Tessa_mesh
+    double output_ms = 0;           // writing text or binary
+
+    // Counters
+    std::size_t snap_merged = 0;        // input points moved onto another by --snap
+    std::size_t snap_dropped_segments = 0; // input segments that --snap made zero length
+    std::size_t simplify_removed = 0;   // input points removed by --simplify
+    std::size_t validation_issues = 0;  // problems --validate found (at most 100 per input)
+    std::size_t input_vertices = 0;     // distinct input points (after snapping and simplifying)
+    std::size_t constraints = 0;        // input segments inserted
+    std::size_t steiner_points = 0;     // vertices added by refinement
+    std::size_t intersection_tests = 0; // segment overlap tests in label repair (bruteforce, indexed)
+    std::size_t output_vertices = 0;
+    std::size_t output_edges = 0;
+    std::size_t cache_hits = 0;         // --cache-dir
+    std::size_t cache_misses = 0;
+
+    // Process wide; filled in by the executable just before writing
+    std::size_t peak_rss_bytes = 0;
+    std::size_t allocations = 0;        // calls to operator new
+
+    Tessa_stats &operator+=( const Tessa_stats &o ) {
+        read_ms += o.read_ms;
+        parse_ms += o.parse_ms;
+        snap_ms += o.snap_ms;
+        simplify_ms += o.simplify_ms;
+        validate_ms += o.validate_ms;
+        insert_vertices_ms += o.insert_vertices_ms;
+        insert_chain_ms += o.insert_chain_ms;
+        refine_ms += o.refine_ms;
+        domain_marking_ms += o.domain_marking_ms;
+        label_repair_ms += o.label_repair_ms;
+        id_cleanup_ms += o.id_cleanup_ms;
+        collect_ms += o.collect_ms;
+        output_ms += o.output_ms;
+        snap_merged += o.snap_merged;
+        snap_dropped_segments += o.snap_dropped_segments;
+        simplify_removed += o.simplify_removed;
+        validation_issues += o.validation_issues;
+        input_vertices += o.input_vertices;
+        constraints += o.constraints;
+        steiner_points += o.steiner_points;
+        intersection_tests += o.intersection_tests;
+        output_vertices += o.output_vertices;
+        output_edges += o.output_edges;
+        cache_hits += o.cache_hits;
+        cache_misses += o.cache_misses;
+        return *this;
+    }
+};
+
+// Adds the time from construction to destruction to ms
+class Stage_timer {
+public:
+    explicit Stage_timer( double &ms ) : ms(ms), start(std::chrono::steady_clock::now()) {}
+    ~Stage_timer() { ms += std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count(); }
+    Stage_timer( const Stage_timer& ) = delete;
+    Stage_timer &operator=( const Stage_timer& ) = delete;
+private:
+    double &ms;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Process wide counters, defined in process_stats.cpp. That file replaces
+// the global operator new to count calls, so only the tessa executable links it.
+std::size_t allocation_count();
+std::size_t peak_rss_bytes(); // 0 if we cannot tell
+
+// One JSON object; input is the input file name, or empty for stdin
+inline void write_stats_json( std::ostream &os, const Tessa_stats &stats, const std::string &input ) {
+    os << "{\n  \"input\": \"";
+    for( char c : input ) {
+        if( c=='"' || c=='\\' ) os << '\\' << c;
+        else if( static_cast<unsigned char>(c)<0x20 ) os << ' ';
+        else os << c;
+    }
+    os << "\",\n  \"stages_ms\": {\n";
+    const std::pair<const char*,double> stages[] = {
+        { "read", stats.read_ms }, { "parse", stats.parse_ms },
+        { "snap", stats.snap_ms }, { "simplify", stats.simplify_ms },
+        { "validate", stats.validate_ms },
+        { "insert_vertices", stats.insert_vertices_ms }, { "insert_chain", stats.insert_chain_ms },
+        { "refine", stats.refine_ms }, { "domain_marking", stats.domain_marking_ms },
+        { "label_repair", stats.label_repair_ms }, { "id_cleanup", stats.id_cleanup_ms },
+        { "collect", stats.collect_ms }, { "output", stats.output_ms } };
+    for( auto &stage : stages ) {
+        os << "    \"" << stage.first << "\": " << stage.second << (&stage==std::end(stages)-1 ? "\n" : ",\n");
+    }
+    os << "  },\n  \"counters\": {\n";
+    const std::pair<const char*,std::size_t> counters[] = {
+        { "snap_merged", stats.snap_merged }, { "snap_dropped_segments", stats.snap_dropped_segments },
+        { "simplify_removed", stats.simplify_removed }, { "validation_issues", stats.validation_issues },
+        { "input_vertices", stats.input_vertices }, { "constraints", stats.constraints },
+        { "steiner_points", stats.steiner_points }, { "intersection_tests", stats.intersection_tests },
+        { "output_vertices", stats.output_vertices }, { "output_edges", stats.output_edges },
+        { "cache_hits", stats.cache_hits }, { "cache_misses", stats.cache_misses },
+        { "peak_rss_bytes", stats.peak_rss_bytes }, { "allocations", stats.allocations } };
+    for( auto &counter : counters ) {
+        os << "    \"" << counter.first << "\": " << counter.second << (&counter==std::end(counters)-1 ? "\n" : ",\n");
+    }
+    os << "  }\n}\n";
+}
+
+#endif //ndef INCLUDED_STATS
\ No newline at end of file
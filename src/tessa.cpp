@@ -0,0 +1,1580 @@
+// std
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+using std::exception;
+
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <set>
+#include <stdexcept>
+#include <type_traits>
+
+#include <limits>
+
+#include <map>
+using std::map;
+
+#include <memory>
+using std::unique_ptr;
+
+#include <mutex>
+
+#include <string>
+using std::string;
+
+#include <tuple>
+using std::tuple;
+using std::get;
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include <vector>
+using std::vector;
+
+#include <chrono>
+using Clock = std::chrono::steady_clock;
+
+#include "tessa.h"
+
+// CGAL
+#include "tessa_triangulation.h"
+
+// logging
+#include "logging.h"
+#include "spdlog/sinks/stdout_color_sinks.h"
+
+// Spatial index for label repair
+#include "chain_index.h"
+
+// Parallel pieces: polygons of a multipolygon, and tiles
+#include "batch.h"
+#include "components.h"
+#include "tiles.h"
+
+// Optional input snapping and simplification
+#include "simplify.h"
+#include "snap.h"
+
+// Optional input validation
+#include "validate.h"
+
+// For hiding "unused variable" warning
+template<typename... Args> inline void unused(Args&&...) {}
+
+// One component: a polygon and the linestrings that go with it
+struct Component {
+    const parser::Polygon *polygon;
+    vector<const parser::LineString*> linestrings;
+};
+
+// Limits on refinement (--max-vertices, --time-limit), shared by all threads
+// working on one input. The vertex limit counts input points and all
+// vertices that refinement adds, over all polygons. Which polygon or tile
+// gets the vertices would depend on the scheduling, so with a vertex limit
+// they refine one after the other, in order; the result is the same for
+// any number of jobs.
+class Budget {
+public:
+    Budget( const Tessa_options &options, size_t input_vertices ) :
+        max_vertices(options.max_vertices), vertices(input_vertices),
+        has_deadline(options.time_limit>0),
+        deadline(Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.time_limit))) {}
+
+    bool unlimited() const { return max_vertices==0 && !has_deadline; }
+
+    // Record n more vertices; false once the budget has run out
+    bool spend( size_t n ) {
+        if( out ) return false;
+        size_t total = vertices += n;
+        if( (max_vertices>0 && total>=max_vertices) || (has_deadline && Clock::now()>=deadline) ) out = true;
+        return !out;
+    }
+    bool exhausted() const { return out; }
+
+    // Threads that may refine at once
+    unsigned jobs( unsigned wanted ) const { return max_vertices>0 ? 1 : wanted; }
+
+private:
+    size_t max_vertices;
+    std::atomic<size_t> vertices;
+    bool has_deadline;
+    Clock::time_point deadline;
+    std::atomic<bool> out{false};
+};
+
+template<typename K> int tessellate( const Component &component, const Tessa_options &options, Tessa_mesh &mesh, Tessa_stats &stats, Budget &budget );
+template<typename K> int tessellate_tiled( const Component &component, const Tessa_options &options, Tessa_mesh &mesh, Tessa_stats &stats, Budget &budget );
+template<typename CDT, typename Step> void refine_within( CDT &cdt, Budget &budget, Step step );
+
+template<typename CDT> void mark_domain( CDT &cdt, const Constraint_types<CDT> &constraint_types, const Wall_counts<CDT> &walls );
+template<typename CDT> void mark_domain( CDT &cdt, const Constraint_types<CDT> &constraint_types, const Wall_counts<CDT> &walls, typename CDT::Face_handle start, bool in_domain );
+template<typename CDT> bool is_seam( CDT &cdt, typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Constraint_types<CDT> &constraint_types );
+template<typename CDT> void collect_vertices( const CDT &cdt, Tessa_mesh &mesh );
+template<typename CDT> void collect_domain_edges( const CDT &cdt, Tessa_mesh &mesh, bool lean = false );
+template<typename Vertex_handle> void add_edge(Tessa_mesh &mesh, Vertex_handle vh1, Vertex_handle vh2, int type, bool lean = false);
+template<typename CDT> void insert_vertices(CDT &cdt, const Component&, vector<vector<typename CDT::Vertex_handle>>&, int&);
+template<typename CDT> void insert_chain(CDT &cdt, const vector<typename CDT::Vertex_handle>&, Chain_edges<CDT>&, Constraint_types<CDT>&, Wall_counts<CDT>&, int&, int);
+template<typename CDT> void add_duplicate( CDT &cdt, typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, int type, Constraint_types<CDT>&, Wall_counts<CDT>& );
+template<typename CDT> int count_walls( CDT &cdt, typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Constraint_types<CDT>&, const Wall_counts<CDT>& );
+template<typename CDT> int edge_type( typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Chain_edges<CDT>& );
+template<typename CDT> int find_edge_type_bruteforce(typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Chain_edges<CDT>&, std::size_t *num_tests = nullptr);
+template<typename CDT> int find_edge_type_hierarchy(CDT &cdt, typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Constraint_types<CDT>&);
+template<typename CDT> void label_edges(CDT &cdt, bool use_hierarchy, const Chain_edges<CDT>&, const Constraint_types<CDT>&);
+
+// The library may be used without the tessa executable setting up logging
+static void ensure_logger() {
+    static std::once_flag once;
+    std::call_once( once, []() {
+        if( console ) return;
+        console = spdlog::get("console");
+        if( console ) return;
+        console = spdlog::stderr_color_mt("console");
+        console->set_pattern("[%^%l%$] %v");
+        console->set_level(spdlog::level::err);
+    });
+}
+
+// Snap and simplify a copy of the input, if asked. Returns the input to
+// tessellate: prepared, or the original if there was nothing to do.
+static const parser::TessaInput &prepare_input( const parser::TessaInput &original_input, const Tessa_options &options,
+                                                parser::TessaInput &prepared, Tessa_stats &stats ) {
+    if( !(options.snap>0) && !(options.simplify>0) ) return original_input;
+    prepared = original_input;
+    if( options.snap>0 ) {
+        snap::Snap_report report;
+        {
+            Stage_timer timer(stats.snap_ms);
+            report = snap::snap(prepared, options.snap);
+        }
+        stats.snap_merged += report.merged;
+        stats.snap_dropped_segments += report.dropped_segments;
+        console->info("Snapped the input with epsilon {}: moved {} points, dropped {} segments and {} rings or linestrings in {} ms",
+            options.snap, report.merged, report.dropped_segments, report.dropped_chains, stats.snap_ms);
+        if( report.dropped_chains>0 ) {
+            console->warn("Snapping with epsilon {} collapsed {} rings or linestrings", options.snap, report.dropped_chains);
+        }
+    }
+    if( options.simplify>0 ) {
+        {
+            Stage_timer timer(stats.simplify_ms);
+            stats.simplify_removed += simplify::simplify(prepared, options.simplify);
+        }
+        console->info("Simplified the input with tolerance {}: removed {} points in {} ms",
+            options.simplify, stats.simplify_removed, stats.simplify_ms);
+    }
+    return prepared;
+}
+
+// Validate the input, if asked, and log what is wrong with it. False if
+// options.validate is "reject" and something is.
+static bool validate_input( const parser::TessaInput &input, const Tessa_options &options, Tessa_stats &stats ) {
+    if( options.validate!="warn" && options.validate!="reject" ) return true;
+    std::vector<validate::Issue> issues;
+    {
+        Stage_timer timer(stats.validate_ms);
+        issues = validate::validate(input);
+    }
+    stats.validation_issues += issues.size();
+    if( issues.empty() ) {
+        console->info("Validated the input in {} ms", stats.validate_ms);
+        return true;
+    }
+    bool reject = options.validate=="reject";
+    for( auto &issue : issues ) {
+        if( reject ) console->error("Invalid input: {} at ({}, {})", issue.what, issue.where.x, issue.where.y);
+        else console->warn("Invalid input: {} at ({}, {})", issue.what, issue.where.x, issue.where.y);
+    }
+    if( reject ) console->error("Rejected the input: {} problems{}", issues.size(), issues.size()>=100 ? " (or more)" : "");
+    return !reject;
+}
+
+// A road that runs through several polygons is in each of their CDTs, and so
+// are its vertices. Outside a polygon's domain a vertex has no edges; such a
+// vertex stays only in the first mesh that has it, and goes from all of them
+// if some mesh has edges on it. Then no point is output twice because of a road.
+static vector<vector<bool>> unique_road_vertices( const vector<Tessa_mesh> &meshes ) {
+    vector<vector<bool>> keep( meshes.size() );
+    vector<vector<bool>> used( meshes.size() );
+    std::unordered_map<Coordinates,bool,Coordinates_hash> loose; // points without edges somewhere -> taken
+    for( size_t i=0; i<meshes.size(); ++i ) {
+        const Tessa_mesh &m = meshes[i];
+        used[i].assign( m.num_vertices(), false );
+        for( int v : m.edge_vertices ) used[i][v] = true;
+        for( size_t v=0; v<m.num_vertices(); ++v ) {
+            if( !used[i][v] ) loose.emplace( Coordinates(m.coordinates[2*v], m.coordinates[2*v+1]), false );
+        }
+    }
+    for( size_t i=0; i<meshes.size(); ++i ) {
+        const Tessa_mesh &m = meshes[i];
+        keep[i].assign( m.num_vertices(), true );
+        if( loose.empty() ) continue;
+        for( size_t v=0; v<m.num_vertices(); ++v ) {
+            if( !used[i][v] ) continue;
+            auto found = loose.find( Coordinates(m.coordinates[2*v], m.coordinates[2*v+1]) );
+            if( found!=loose.end() ) found->second = true;
+        }
+    }
+    for( size_t i=0; i<meshes.size(); ++i ) {
+        const Tessa_mesh &m = meshes[i];
+        for( size_t v=0; v<m.num_vertices() && !loose.empty(); ++v ) {
+            if( used[i][v] ) continue;
+            auto found = loose.find( Coordinates(m.coordinates[2*v], m.coordinates[2*v+1]) );
+            if( found->second ) keep[i][v] = false;
+            else found->second = true;
+        }
+    }
+    return keep;
+}
+
+int tessellate( const parser::TessaInput &original_input, const Tessa_options &options, Tessa_mesh &mesh, Tessa_stats *stats ) {
+    ensure_logger();
+
+    parser::TessaInput prepared;
+    Tessa_stats prepare_stats;
+    const parser::TessaInput &input = prepare_input(original_input, options, prepared, prepare_stats);
+    bool valid = validate_input(input, options, prepare_stats);
+    if( stats ) *stats += prepare_stats;
+    if( !valid ) return tessa_invalid;
+    if( input.polygons.empty() ) {
+        console->error("Nothing to tessellate: snapping with epsilon {} collapsed every polygon", options.snap);
+        return tessa_invalid;
+    }
+
+    // The polygons of a multipolygon are disjoint, so each gets its own CDT
+    auto assigned = components::assign_linestrings(input);
+    vector<Component> components( input.polygons.size() );
+    for( size_t i=0; i<components.size(); ++i ) {
+        components[i].polygon = &input.polygons[i];
+        for( size_t l : assigned[i] ) components[i].linestrings.push_back( &input.linestrings[l] );
+    }
+    size_t input_vertices = 0;
+    for( auto &polygon : input.polygons ) for( auto &ring : polygon ) input_vertices += ring.size();
+    for( auto &linestring : input.linestrings ) input_vertices += linestring.size();
+    Budget budget( options, input_vertices );
+    auto tessellate_component = [&]( const Component &component, Tessa_mesh &component_mesh, Tessa_stats &component_stats ) {
+        return options.kernel=="epick" ? tessellate<Epick>(component, options, component_mesh, component_stats, budget)
+                                       : tessellate<Epeck>(component, options, component_mesh, component_stats, budget);
+    };
+    auto out_of_budget = [&]() {
+        console->warn("Refinement stopped early: out of {}; the result is valid and labeled, but does not meet the criteria everywhere",
+            options.time_limit>0 && options.max_vertices>0 ? "vertices or time" : options.time_limit>0 ? "time" : "vertices");
+        return tessa_partial;
+    };
+    if( components.size()==1 ) {
+        Tessa_stats component_stats;
+        int result = tessellate_component(components[0], mesh, component_stats);
+        if( stats ) *stats += component_stats;
+        return budget.exhausted() ? out_of_budget() : result;
+    }
+
+    console->info("Tessellating {} polygons on {} threads", components.size(), budget.jobs(options.jobs));
+    vector<Tessa_mesh> meshes( components.size() );
+    vector<Tessa_stats> component_stats( components.size() );
+    vector<int> results( components.size(), 0 );
+    vector<std::exception_ptr> errors( components.size() );
+    parallel_for( components.size(), budget.jobs(options.jobs), [&]( size_t i ) {
+        try {
+            results[i] = tessellate_component(components[i], meshes[i], component_stats[i]);
+        } catch( ... ) {
+            errors[i] = std::current_exception();
+        }
+    });
+    for( size_t i=0; i<components.size(); ++i ) {
+        if( errors[i] ) std::rethrow_exception(errors[i]);
+    }
+    auto keep = unique_road_vertices(meshes);
+
+    // Concatenate in input order, so vertex ids run on from one polygon to the next
+    size_t total_vertices = 0, total_edges = 0;
+    for( auto &component_mesh : meshes ) {
+        total_vertices += component_mesh.num_vertices();
+        total_edges += component_mesh.num_edges();
+    }
+    mesh.coordinates.reserve(2*total_vertices);
+    mesh.edge_vertices.reserve(2*total_edges);
+    mesh.edge_lengths.reserve(total_edges);
+    mesh.edge_types.reserve(total_edges);
+    int result = 0;
+    for( size_t i=0; i<components.size(); ++i ) {
+        if( result==0 ) result = results[i];
+        if( stats ) *stats += component_stats[i];
+        mesh.append(meshes[i], &keep[i]);
+        meshes[i] = Tessa_mesh(); // free as we go
+    }
+    return budget.exhausted() ? out_of_budget() : result;
+}
+
+parser::TessaInput make_input( const double *xy, const std::size_t *chain_sizes, std::size_t num_chains, std::size_t num_rings ) {
+    parser::TessaInput input;
+    input.polygons.resize(1);
+    for( std::size_t c=0; c<num_chains; ++c ) {
+        parser::Points chain( chain_sizes[c] );
+        for( auto &p : chain ) {
+            p = { xy[0], xy[1] };
+            xy += 2;
+        }
+        if( c<num_rings ) input.polygons[0].push_back( std::move(chain) );
+        else input.linestrings.push_back( std::move(chain) );
+    }
+    return input;
+}
+
+template<typename K>
+int tessellate( const Component &component, const Tessa_options &options, Tessa_mesh &mesh, Tessa_stats &stats, Budget &budget ) {
+    typedef typename Tessa_triangulation<K>::CDT      CDT;
+    typedef typename Tessa_triangulation<K>::Criteria Criteria;
+    typedef typename CDT::Vertex_handle               Vertex_handle;
+
+    if( options.tiles>1 ) {
+        if( options.make_mesh && !options.make_cdt && !options.make_gabriel ) {
+            return tessellate_tiled<K>(component, options, mesh, stats, budget);
+        }
+        console->warn("--tiles only works with just --mesh; doing this in one piece");
+    }
+    auto stage_ms = []( Clock::time_point from, Clock::time_point to ) {
+        return std::chrono::duration<double,std::milli>(to-from).count();
+    };
+
+    // Insert all vertices of all rings and linestrings in one go
+    // Vertex ids are assigned consecutively from 0, in input order
+    CDT cdt;
+    int index = 0;
+    vector<vector<Vertex_handle>> cgal_polygon; // vector of rings; index 0 is outer ring
+    auto start_time = Clock::now();
+    insert_vertices( cdt, component, cgal_polygon, index );
+    auto vertex_time = Clock::now();
+    console->info("Number of input vertices: {}", cdt.number_of_vertices() );
+
+    // Iterate over the rings of the parsed polygon:
+    // Add all line segments to the CDT
+    Chain_edges<CDT> chain_edges; // vector of edge sets of the rings/chains
+    Constraint_types<CDT> constraint_types; // type of each input constraint; survives subdivision
+    Wall_counts<CDT> walls; // boundary and hole segments inserted more than once
+    int num_edges_inserted = 0;
+    for( size_t i=0; i<cgal_polygon.size(); ++i ) {
+        // first ring has type 0, further rings have type 1,
+        // and then come the linestrings from the multilinestring (could be none)
+        int type = i==0 ? 0 : i<component.polygon->size() ? 1 : 2;
+        insert_chain( cdt, cgal_polygon[i], chain_edges, constraint_types, walls, num_edges_inserted, type );
+    }
+    auto constraint_time = Clock::now();
+    console->info("Number of edges inserted: {}", num_edges_inserted );
+    console->info("Inserted vertices in {} ms and constraints in {} ms",
+        stage_ms(start_time, vertex_time), stage_ms(vertex_time, constraint_time) );
+    stats.insert_vertices_ms += stage_ms(start_time, vertex_time);
+    stats.insert_chain_ms += stage_ms(vertex_time, constraint_time);
+    stats.input_vertices += index;
+    stats.constraints += num_edges_inserted;
+
+    // keep track of if we did something so we can give a warning
+    // *and* because we give different output in that case
+    bool did_something = false;
+    bool should_repair_labels = false;
+
+    // make cdt?
+    if( options.make_cdt ) {
+        did_something = true;
+        should_repair_labels = true; // conforming splits input edges too
+        console->info("Making conforming Delauney triangulation...");
+        try {
+            {
+                Stage_timer timer(stats.refine_ms);
+                if( budget.unlimited() ) {
+                    CGAL::make_conforming_Delaunay_2(cdt);
+                } else {
+                    CGAL::Triangulation_conformer_2<CDT> conformer(cdt);
+                    conformer.init_Delaunay();
+                    refine_within( cdt, budget, [&]() { return conformer.step_by_step_conforming_Delaunay(); } );
+                }
+            }
+            Stage_timer timer(stats.domain_marking_ms);
+            mark_domain( cdt, constraint_types, walls );
+        } catch( exception &x ) {
+            console->error(x.what());
+        }
+        console->info("Number of vertices is now: {}", cdt.number_of_vertices() );
+    }
+
+    // make mesh?
+    if( options.make_mesh ) {
+        did_something = true;
+        should_repair_labels = true;
+        console->info("Making mesh with parameters B={} and S={} ...", options.meshing_param_B, options.meshing_param_S);
+        Criteria crit(options.meshing_param_B,options.meshing_param_S);
+        // mark the domain ourselves; the mesher keeps the marks up to date as it inserts points
+        {
+            Stage_timer timer(stats.domain_marking_ms);
+            mark_domain( cdt, constraint_types, walls );
+        }
+        Stage_timer timer(stats.refine_ms);
+        CGAL::Delaunay_mesher_2<CDT,Criteria> mesher(cdt, crit);
+        mesher.init(true); // domain is already initialized
+        if( budget.unlimited() ) mesher.refine_mesh();
+        else refine_within( cdt, budget, [&]() { return mesher.step_by_step_refine_mesh(); } );
+
+        console->info("Number of vertices is now: {}", cdt.number_of_vertices() );
+    }
+
+    // make conforming Gabriel?
+    if( options.make_gabriel ) {
+        did_something = true;
+        should_repair_labels = true;
+        console->info("Making conforming Gabriel graph...");
+        try {
+            {
+                Stage_timer timer(stats.refine_ms);
+                if( budget.unlimited() ) {
+                    CGAL::make_conforming_Gabriel_2(cdt);
+                } else {
+                    CGAL::Triangulation_conformer_2<CDT> conformer(cdt);
+                    conformer.init_Gabriel();
+                    refine_within( cdt, budget, [&]() { return conformer.step_by_step_conforming_Gabriel(); } );
+                }
+            }
+            Stage_timer timer(stats.domain_marking_ms);
+            mark_domain( cdt, constraint_types, walls );
+        } catch( exception &x ) {
+            console->error(x.what());
+        }
+        console->info("Number of vertices is now: {}", cdt.number_of_vertices() );
+    }
+
+    stats.steiner_points += cdt.number_of_vertices() - index;
+
+    // Reconstruct original labels if we may have messed them up
+    // (the constraint hierarchy never loses them, so only the geometric methods need this)
+    auto repair_time = Clock::now();
+    if( should_repair_labels && options.repair_method!="hierarchy" ) {
+        console->info("Repairing labels ({})", options.repair_method);
+        unique_ptr<Chain_edge_index<CDT>> chain_index;
+        if( options.repair_method=="indexed" ) {
+            chain_index = std::make_unique<Chain_edge_index<CDT>>(chain_edges);
+            console->info("Built spatial index over {} chain edges", chain_index->size());
+        }
+        // This is before cleaning up the ids, so any newly introduced points have id -1
+        // Adjacent edges could be mesh edges, which is fine, but maybe we subdivided
+        // a "boundary", "hole" or "road" edge.
+        Chain_edges<CDT> new_chain_edges;
+        for( auto ei : cdt.finite_edges() ) {
+            typename CDT::Face& f = *(ei.first);
+            int i = ei.second;
+            auto vh1 = f.vertex(f.cw(i));
+            auto vh2 = f.vertex(f.ccw(i));
+            if (vh1->id() == -1 || vh2->id() == -1) {
+                // At least one of the vertices is new; we need to check it
+                int original_type = chain_index ? chain_index->find_edge_type(vh1, vh2, &stats.intersection_tests)
+                                                : find_edge_type_bruteforce<CDT>(vh1, vh2, chain_edges, &stats.intersection_tests);
+                if( original_type != -1 ) {
+                    //console->info("The segment ({},{})-({},{}) is actually of type {}", vh1->point().x(), vh1->point().y(), vh2->point().x(), vh2->point().y(), original_type);
+                    new_chain_edges[{vh1,vh2}] = original_type;
+                }
+            }
+        }
+        chain_edges.merge(new_chain_edges);
+        console->info("Done repairing edges");
+    }
+
+    // Store the type of every edge in its faces, so output needs no lookups
+    if( did_something ) {
+        label_edges( cdt, options.repair_method=="hierarchy", chain_edges, constraint_types );
+    }
+    stats.label_repair_ms += stage_ms(repair_time, Clock::now());
+
+    // Clean up data structure
+    auto cleanup_time = Clock::now();
+    if( did_something ) {
+        // give ids to any vertices that were introduced
+        for( auto vh : cdt.finite_vertex_handles() ) {
+            if( vh->id()==-1 ) vh->id() = index++;
+        }
+    } else {
+        console->warn("Did not do anything to the input.");
+    }
+    stats.id_cleanup_ms += stage_ms(cleanup_time, Clock::now());
+
+    // Lean: the labels are in the faces now, so the maps can go before
+    // collecting, which is when the CDT and the mesh are both alive
+    if( options.lean && did_something ) {
+        Chain_edges<CDT>().swap(chain_edges);
+        Constraint_types<CDT>().swap(constraint_types);
+        Wall_counts<CDT>().swap(walls);
+        vector<vector<Vertex_handle>>().swap(cgal_polygon);
+    }
+
+    // === Collect the result
+    Stage_timer collect_timer(stats.collect_ms);
+    collect_vertices( cdt, mesh );
+    if( did_something ) {
+        collect_domain_edges( cdt, mesh, options.lean );
+    } else {
+        mesh.num_triangulation_edges = 0; // there is no number_of_edges?
+        for( auto ei : cdt.finite_edges() ) { unused(ei); ++mesh.num_triangulation_edges; } // count edges "by hand" instead
+        // spit out original edges
+        for( auto &ring : cgal_polygon ) {
+            if( ring.empty() ) continue;
+            Vertex_handle vh1 = ring[0];
+            for( Vertex_handle vh2 : ring ) {
+                if( vh1!=vh2 ) {
+                    int type = edge_type<CDT>(vh1,vh2,chain_edges);
+                    add_edge( mesh, vh1, vh2, type, options.lean );
+                }
+                vh1 = vh2;
+            }
+        }
+    }
+    stats.output_vertices += mesh.num_vertices();
+    stats.output_edges += mesh.num_edges();
+
+    return 0;
+
+}
+
+template<typename K>
+int tessellate_tiled( const Component &component, const Tessa_options &options, Tessa_mesh &mesh, Tessa_stats &stats, Budget &budget ) {
+    // Crossing constraints are fine here: the tile borders cut the input
+    typedef typename Tessa_triangulation<K,CGAL::Exact_predicates_tag>::CDT      CDT;
+    typedef typename Tessa_triangulation<K,CGAL::Exact_predicates_tag>::Criteria Criteria;
+    typedef typename CDT::Point                                                  Point;
+    typedef typename CDT::Vertex_handle                                          Vertex_handle;
+    typedef typename CDT::Face_handle                                            Face_handle;
+    typedef typename CDT::Constraint_id                                          Constraint_id;
+
+    // The chains, with the types the single run would give them
+    vector<const parser::Points*> chains;
+    vector<int> chain_types;
+    for( size_t i=0; i<component.polygon->size(); ++i ) {
+        chains.push_back( &(*component.polygon)[i] );
+        chain_types.push_back( i==0 ? 0 : 1 );
+    }
+    for( auto linestring : component.linestrings ) {
+        chains.push_back( linestring );
+        chain_types.push_back( 2 );
+    }
+    double xmin = std::numeric_limits<double>::max(), ymin = xmin;
+    double xmax = std::numeric_limits<double>::lowest(), ymax = xmax;
+    for( auto chain : chains ) {
+        for( parser::Point p : *chain ) {
+            xmin = std::min(xmin,p.x); xmax = std::max(xmax,p.x);
+            ymin = std::min(ymin,p.y); ymax = std::max(ymax,p.y);
+        }
+    }
+    if( xmin>xmax ) {
+        console->warn("Nothing to tile");
+        return 0;
+    }
+    Tile_grid grid( xmin, ymin, xmax, ymax, options.tiles );
+    console->info("Meshing in {} tiles on {} threads", grid.size(), options.jobs);
+    auto start_time = Clock::now();
+
+    // Every input segment goes to every tile its bounding box touches
+    struct Segment_ref { size_t chain, i; }; // from point i to point i+1
+    vector<vector<Segment_ref>> tile_segments( grid.size() );
+    for( size_t c=0; c<chains.size(); ++c ) {
+        const parser::Points &chain = *chains[c];
+        for( size_t i=0; i+1<chain.size(); ++i ) {
+            parser::Point p = chain[i], q = chain[i+1];
+            if( p.x==q.x && p.y==q.y ) continue; // length zero; the single run skips these too
+            ++stats.constraints;
+            for( int row=grid.first_row(std::min(p.y,q.y)); row<=grid.last_row(std::max(p.y,q.y)); ++row ) {
+                for( int column=grid.first_column(std::min(p.x,q.x)); column<=grid.last_column(std::max(p.x,q.x)); ++column ) {
+                    tile_segments[grid.tile(column,row)].push_back({c,i});
+                }
+            }
+        }
+    }
+
+    // Is p inside the polygon? Odd number of ring crossings on the ray to +x.
+    // p must not lie on a ring.
+    auto in_polygon = [&]( const Point &p ) {
+        double py = CGAL::to_double(p.y());
+        bool inside = false;
+        for( auto &ring : *component.polygon ) {
+            for( size_t i=0; i+1<ring.size(); ++i ) {
+                // cheap filter first, with some slack for the rounding of py
+                if( std::max(ring[i].y,ring[i+1].y)<py-1 || std::min(ring[i].y,ring[i+1].y)>py+1 ) continue;
+                Point a( ring[i].x, ring[i].y ), b( ring[i+1].x, ring[i+1].y );
+                bool up = a.y()<=p.y() && b.y()>p.y();
+                bool down = b.y()<=p.y() && a.y()>p.y();
+                if( (up && CGAL::orientation(a,b,p)==CGAL::LEFT_TURN) || (down && CGAL::orientation(a,b,p)==CGAL::RIGHT_TURN) ) {
+                    inside = !inside;
+                }
+            }
+        }
+        return inside;
+    };
+
+    struct Tile {
+        CDT cdt;
+        Constraint_types<CDT> constraint_types;
+        Wall_counts<CDT> walls;
+        vector<Constraint_id> seams;
+        Point seed;           // a point in the tile that is not on any ring; never moves
+        bool seed_in_domain;
+        std::unordered_set<Coordinates,Coordinates_hash> seam_points; // known on both sides
+        vector<Coordinates> inbox;  // seam points from the neighbours, still to insert
+        vector<Coordinates> outbox; // seam points of ours, new this round
+    };
+    vector<Tile> tiles( grid.size() );
+
+    auto mark = [&]( Tile &tile ) {
+        mark_domain( tile.cdt, tile.constraint_types, tile.walls, tile.cdt.locate(tile.seed), tile.seed_in_domain );
+    };
+
+    // Build every tile: border, then its part of the input
+    parallel_for( grid.size(), options.jobs, [&]( size_t t ) {
+        Tile &tile = tiles[t];
+        Point corners[4] = { Point(grid.x0(t),grid.y0(t)), Point(grid.x1(t),grid.y0(t)),
+                             Point(grid.x1(t),grid.y1(t)), Point(grid.x0(t),grid.y1(t)) };
+        Vertex_handle vc[4];
+        for( int k=0; k<4; ++k ) vc[k] = tile.cdt.insert(corners[k]);
+        for( int k=0; k<4; ++k ) {
+            Constraint_id cid = tile.cdt.insert_constraint( vc[k], vc[(k+1)%4] );
+            tile.constraint_types[cid] = seam_type;
+            tile.seams.push_back(cid);
+        }
+        Face_handle hint;
+        for( Segment_ref s : tile_segments[t] ) {
+            const parser::Points &chain = *chains[s.chain];
+            Vertex_handle va = tile.cdt.insert( Point(chain[s.i].x, chain[s.i].y), hint );
+            Vertex_handle vb = tile.cdt.insert( Point(chain[s.i+1].x, chain[s.i+1].y), va->face() );
+            hint = vb->face();
+            Constraint_id cid = tile.cdt.insert_constraint( va, vb );
+            if( cid!=Constraint_id(nullptr) ) tile.constraint_types[cid] = chain_types[s.chain];
+            else add_duplicate( tile.cdt, va, vb, chain_types[s.chain], tile.constraint_types, tile.walls );
+        }
+        vector<Segment_ref>().swap(tile_segments[t]);
+        // No face crosses a constraint, so a face's centroid is not on any ring
+        Face_handle f = tile.cdt.locate( CGAL::midpoint(corners[0], corners[2]) );
+        tile.seed = CGAL::centroid( f->vertex(0)->point(), f->vertex(1)->point(), f->vertex(2)->point() );
+        tile.seed_in_domain = in_polygon(tile.seed);
+    });
+    auto build_time = Clock::now();
+
+    // Refine all tiles, then hand the points that refinement put on a seam
+    // to the tiles on the other side, and refine again, until the tiles agree
+    // on all their seams.
+    Criteria crit(options.meshing_param_B, options.meshing_param_S);
+    const int max_rounds = 100;
+    int round = 0;
+    size_t exchanged = 0;
+    do {
+        parallel_for( grid.size(), budget.jobs(options.jobs), [&]( size_t t ) {
+            Tile &tile = tiles[t];
+            for( Coordinates c : tile.inbox ) tile.cdt.insert( Point(c.first, c.second) );
+            vector<Coordinates>().swap(tile.inbox);
+            mark(tile);
+            CGAL::Delaunay_mesher_2<CDT,Criteria> mesher(tile.cdt, crit);
+            mesher.init(true); // domain is already initialized
+            if( budget.unlimited() ) mesher.refine_mesh();
+            else refine_within( tile.cdt, budget, [&]() { return mesher.step_by_step_refine_mesh(); } );
+            // seam points we have not seen yet; the outer border has no neighbours, but that is fine
+            for( Constraint_id cid : tile.seams ) {
+                for( auto vi = tile.cdt.vertices_in_constraint_begin(cid); vi!=tile.cdt.vertices_in_constraint_end(cid); ++vi ) {
+                    Coordinates c{ CGAL::to_double((*vi)->point().x()), CGAL::to_double((*vi)->point().y()) };
+                    if( tile.seam_points.insert(c).second ) tile.outbox.push_back(c);
+                }
+            }
+        });
+        exchanged = 0;
+        for( size_t t=0; t<tiles.size(); ++t ) {
+            for( Coordinates c : tiles[t].outbox ) {
+                // a point on a grid line belongs to the tiles on both sides
+                for( int row=grid.first_row(c.second); row<=grid.last_row(c.second); ++row ) {
+                    for( int column=grid.first_column(c.first); column<=grid.last_column(c.first); ++column ) {
+                        Tile &other = tiles[grid.tile(column,row)];
+                        if( &other==&tiles[t] ) continue;
+                        if( other.seam_points.insert(c).second ) {
+                            other.inbox.push_back(c);
+                            ++exchanged;
+                        }
+                    }
+                }
+            }
+            vector<Coordinates>().swap(tiles[t].outbox);
+        }
+        ++round;
+        console->info("Round {}: {} seam points exchanged", round, exchanged);
+    } while( exchanged>0 && round<max_rounds && !budget.exhausted() );
+    if( budget.exhausted() ) {
+        // Out of budget: no more refinement, but the neighbours still take
+        // the last seam points, which adds no new ones, so the seams match
+        parallel_for( grid.size(), options.jobs, [&]( size_t t ) {
+            for( Coordinates c : tiles[t].inbox ) tiles[t].cdt.insert( Point(c.first, c.second) );
+            vector<Coordinates>().swap(tiles[t].inbox);
+        });
+    } else if( exchanged>0 ) {
+        console->warn("Seams did not settle in {} rounds; the mesh may have T-junctions there", max_rounds);
+    }
+    auto mesh_time = Clock::now();
+
+    // Final marks and edge types
+    parallel_for( grid.size(), options.jobs, [&]( size_t t ) {
+        mark(tiles[t]);
+        label_edges( tiles[t].cdt, true, Chain_edges<CDT>(), tiles[t].constraint_types );
+    });
+    auto label_time = Clock::now();
+
+    // === Stitch
+    // Input vertices get the ids the single run gives them, in input order;
+    // then come the new vertices on domain edges, tile by tile, as the edges
+    // come. Tile corners and seam points outside the domain are not output,
+    // as the single run does not have them. Seam vertices are in several
+    // tiles, and get one id.
+    std::unordered_map<Coordinates,int,Coordinates_hash> ids;
+    auto id_of = [&]( Coordinates c ) {
+        auto [it,is_new] = ids.emplace( c, static_cast<int>(mesh.num_vertices()) );
+        if( is_new ) {
+            mesh.coordinates.push_back(c.first);
+            mesh.coordinates.push_back(c.second);
+        }
+        return it->second;
+    };
+    for( auto chain : chains ) {
+        for( parser::Point p : *chain ) id_of( {p.x,p.y} );
+    }
+    size_t num_input_vertices = mesh.num_vertices();
+    mesh.num_triangulation_edges = 0;
+    auto coordinates_of = []( Vertex_handle vh ) {
+        return Coordinates{ CGAL::to_double(vh->point().x()), CGAL::to_double(vh->point().y()) };
+    };
+    std::set<std::pair<Coordinates,Coordinates>> seam_edges;
+    for( size_t t=0; t<tiles.size(); ++t ) {
+        CDT &cdt = tiles[t].cdt;
+        for( auto vh : cdt.finite_vertex_handles() ) vh->id() = -1;
+        auto give_id = [&]( Vertex_handle vh ) {
+            if( vh->id()==-1 ) vh->id() = id_of( coordinates_of(vh) );
+        };
+        // edges of the faces in this tile (the flood fill visited exactly those)
+        for( auto ei : cdt.finite_edges() ) {
+            typename CDT::Face& f = *(ei.first);
+            int i = ei.second;
+            auto other_f = f.neighbor(i);
+            if( !f.is_visited() && !other_f->is_visited() ) continue;
+            auto vh1 = f.vertex(f.cw(i));
+            auto vh2 = f.vertex(f.ccw(i));
+            if( f.is_visited()!=other_f->is_visited() ) {
+                // on the tile border, so maybe also in the neighbour
+                Coordinates a = coordinates_of(vh1), b = coordinates_of(vh2);
+                if( !seam_edges.emplace( std::min(a,b), std::max(a,b) ).second ) continue;
+            }
+            ++mesh.num_triangulation_edges;
+            if( f.is_in_domain() || other_f->is_in_domain() ) {
+                give_id(vh1);
+                give_id(vh2);
+                add_edge( mesh, vh1, vh2, f.edge_type(i), options.lean );
+            }
+        }
+        cdt.clear(); // free as we go
+        tiles[t].constraint_types.clear();
+        tiles[t].walls.clear();
+    }
+    console->info("Meshed in {} ms and {} rounds; {} vertices",
+        std::chrono::duration<double,std::milli>(mesh_time-start_time).count(), round, mesh.num_vertices());
+
+    // The tiles run side by side, so these are wall clock times
+    auto stage_ms = []( Clock::time_point from, Clock::time_point to ) {
+        return std::chrono::duration<double,std::milli>(to-from).count();
+    };
+    stats.insert_chain_ms += stage_ms(start_time, build_time);
+    stats.refine_ms += stage_ms(build_time, mesh_time);
+    stats.label_repair_ms += stage_ms(mesh_time, label_time);
+    stats.id_cleanup_ms += stage_ms(label_time, Clock::now());
+    stats.input_vertices += num_input_vertices;
+    stats.steiner_points += mesh.num_vertices() - num_input_vertices;
+    stats.output_vertices += mesh.num_vertices();
+    stats.output_edges += mesh.num_edges();
+
+    return 0;
+}
+
+template<typename CDT>
+void collect_vertices( const CDT &cdt, Tessa_mesh &mesh ) {
+    // Vertex i goes to place i. The vertex container runs in insertion
+    // order, which is spatial sort order (see insert_vertices), so gather
+    // the vertices by id first and write them in id order.
+    vector<typename CDT::Vertex_handle> by_id( cdt.number_of_vertices() );
+    bool warned_bad_ids = false;
+    for( auto vh : cdt.finite_vertex_handles() ) {
+        int id = vh->id();
+        if( id<0 || id>=static_cast<int>(by_id.size()) || by_id[id]!=typename CDT::Vertex_handle() ) {
+            if( !warned_bad_ids ) console->error("Watch out! Vertex ids are not consecutive from 0.");
+            warned_bad_ids = true;
+            continue;
+        }
+        by_id[id] = vh;
+    }
+    mesh.coordinates.assign( 2*by_id.size(), 0.0 );
+    for( size_t id=0; id<by_id.size(); ++id ) {
+        if( by_id[id]==typename CDT::Vertex_handle() ) continue;
+        mesh.coordinates[2*id] = CGAL::to_double(by_id[id]->point().x());
+        mesh.coordinates[2*id+1] = CGAL::to_double(by_id[id]->point().y());
+    }
+}
+
+template<typename CDT>
+void collect_domain_edges( const CDT &cdt, Tessa_mesh &mesh, bool lean ) {
+    // Lean: an extra pass to count the edges in the domain, so that the
+    // arrays get exactly the room they need instead of growing by doubling
+    if( lean ) {
+        size_t n = 0;
+        for( auto ei : cdt.finite_edges() ) {
+            if( ei.first->is_in_domain() || ei.first->neighbor(ei.second)->is_in_domain() ) ++n;
+        }
+        mesh.edge_vertices.reserve(2*n);
+        mesh.edge_lengths.reserve(n);
+        mesh.edge_types.reserve(n);
+    }
+
+    // One pass over the edges: count all of them (that is what the text header
+    // reports) while collecting the ones in the domain.
+    mesh.num_triangulation_edges = 0; // there is no number_of_edges?
+    for( auto ei : cdt.finite_edges() ) {
+        ++mesh.num_triangulation_edges;
+        typename CDT::Face& f = *(ei.first);
+        int i = ei.second;
+        auto other_f = f.neighbor(i);
+        if( f.is_in_domain() || other_f->is_in_domain() ) {
+            auto vh1 = f.vertex(f.cw(i));
+            auto vh2 = f.vertex(f.ccw(i));
+            add_edge( mesh, vh1, vh2, f.edge_type(i), lean );
+        }
+    }
+}
+
+template<typename CDT>
+void mark_domain( CDT &cdt, const Constraint_types<CDT> &constraint_types, const Wall_counts<CDT> &walls ) {
+    mark_domain( cdt, constraint_types, walls, cdt.infinite_face(), false );
+}
+
+template<typename CDT>
+void mark_domain( CDT &cdt, const Constraint_types<CDT> &constraint_types, const Wall_counts<CDT> &walls, typename CDT::Face_handle start, bool in_domain ) {
+    // Flood fill from start. Crossing a boundary or hole edge takes us one
+    // level deeper; road edges are transparent, and so is an edge with an even
+    // number of boundary and hole segments on it (a hole touching the outer
+    // ring along an edge: that edge is a wall twice). Faces at odd depth are inside
+    // the polygon (when starting outside). Seams (tile borders) are never
+    // crossed, and faces beyond them are left unvisited and out of the domain.
+    // Every face is visited once, so this is linear.
+    typedef typename CDT::Face_handle Face_handle;
+    for( auto f : cdt.all_face_handles() ) {
+        f->set_in_domain(false);
+        f->set_visited(false);
+    }
+    vector<Face_handle> frontier{ start }; // faces just across a boundary or hole edge
+    vector<Face_handle> stack;
+    while( !frontier.empty() ) {
+        vector<Face_handle> next_frontier;
+        for( Face_handle start : frontier ) {
+            if( start->is_visited() ) continue;
+            start->set_visited(true);
+            stack.push_back(start);
+            while( !stack.empty() ) {
+                Face_handle f = stack.back();
+                stack.pop_back();
+                f->set_in_domain(in_domain);
+                for( int i=0; i<3; ++i ) {
+                    Face_handle n = f->neighbor(i);
+                    if( n->is_visited() ) continue;
+                    bool is_wall = false;
+                    if( f->is_constrained(i) ) {
+                        auto a = f->vertex(f->cw(i));
+                        auto b = f->vertex(f->ccw(i));
+                        if( is_seam(cdt, a, b, constraint_types) ) continue;
+                        is_wall = count_walls( cdt, a, b, constraint_types, walls )%2==1;
+                    }
+                    if( is_wall ) {
+                        next_frontier.push_back(n);
+                    } else {
+                        n->set_visited(true);
+                        stack.push_back(n);
+                    }
+                }
+            }
+        }
+        frontier.swap(next_frontier);
+        in_domain = !in_domain;
+    }
+}
+
+template<typename Vertex_handle>
+void add_edge(Tessa_mesh &mesh, Vertex_handle vh1, Vertex_handle vh2, int type, bool lean) {
+    double distance;
+    if( lean ) {
+        // From the collected coordinates: no exact number trees get built
+        // (or evaluated) per edge; may differ from the exact length in the last bit
+        const double *a = &mesh.coordinates[2*vh1->id()], *b = &mesh.coordinates[2*vh2->id()];
+        distance = (a[0]-b[0])*(a[0]-b[0]) + (a[1]-b[1])*(a[1]-b[1]);
+    } else {
+        distance = CGAL::to_double( (vh1->point()-vh2->point()).squared_length() );
+    }
+    mesh.add_edge( vh1->id(), vh2->id(), distance, type );
+}
+
+template<typename CDT>
+void insert_vertices(CDT &cdt, const Component &component, vector<vector<typename CDT::Vertex_handle>> &cgal_polygon, int &index ) {
+    typedef typename CDT::Geom_traits   K;
+    typedef typename CDT::Point         Point;
+    typedef typename CDT::Vertex_handle Vertex_handle;
+    // Gather the points of all chains: outer ring, holes, then linestrings
+    vector<Point> points;
+    vector<size_t> chain_begin; // where each chain starts in points
+    chain_begin.reserve(component.polygon->size()+component.linestrings.size()+1);
+    auto gather = [&]( const parser::Points &chain ) {
+        chain_begin.push_back(points.size());
+        for( parser::Point p : chain ) points.emplace_back(p.x, p.y);
+    };
+    for( auto &ring : *component.polygon ) gather(ring);
+    for( auto chain : component.linestrings ) gather(*chain);
+    chain_begin.push_back(points.size());
+
+    // Insert in spatial sort order, each time starting the point location
+    // at the previous vertex; this is what CGAL's range insert does, but we
+    // need to keep the vertex handle of every input point.
+    vector<size_t> order(points.size());
+    for( size_t i=0; i<order.size(); ++i ) order[i] = i;
+    typedef CGAL::Spatial_sort_traits_adapter_2<K, typename CGAL::Pointer_property_map<Point>::type> Sort_traits;
+    CGAL::spatial_sort( order.begin(), order.end(), Sort_traits(CGAL::make_property_map(points)) );
+    vector<Vertex_handle> handles(points.size());
+    typename CDT::Face_handle hint;
+    for( size_t i : order ) {
+        handles[i] = cdt.insert( points[i], hint );
+        hint = handles[i]->face();
+    }
+
+    // Assign ids in input order, so they do not depend on the insertion order;
+    // the output is written by id (collect_vertices), not in container order
+    cgal_polygon.reserve(chain_begin.size()-1);
+    for( size_t c=0; c+1<chain_begin.size(); ++c ) {
+        cgal_polygon.emplace_back( handles.begin()+chain_begin[c], handles.begin()+chain_begin[c+1] );
+        for( auto &v : cgal_polygon.back() ) {
+            if( v->id()==-1 ) v->id() = index++; // only assign id if this vertex is new (-1 is default value)
+        }
+    }
+}
+
+template<typename CDT>
+void insert_chain(CDT &cdt, const vector<typename CDT::Vertex_handle>& cgal_polygon, Chain_edges<CDT> &chain_edges, Constraint_types<CDT> &constraint_types, Wall_counts<CDT> &walls, int &num_edges_inserted, int type ) {
+    typedef typename CDT::Constraint_id Constraint_id;
+    int n = cgal_polygon.size();
+    if( n<=1 ) return; // don't try to make edges if we have only a single vertex
+    for( int i=0; i<n-1; ++i ) {
+        if (cgal_polygon[i]->id() == cgal_polygon[i + 1]->id()) {
+            //console->warn("Skipping a length-zero edge at {} {}", cgal_polygon[i]->point().x(), cgal_polygon[i]->point().y());
+            continue;
+        }
+        // both endpoints are already in the triangulation, so this is a local operation
+        Constraint_id cid = cdt.insert_constraint( cgal_polygon[i], cgal_polygon[i+1] );
+        // a null id means this exact constraint was already there: it gets counted on that one
+        if( cid!=Constraint_id(nullptr) ) constraint_types[cid] = type;
+        else add_duplicate( cdt, cgal_polygon[i], cgal_polygon[i+1], type, constraint_types, walls );
+        console->info("Inserting edge {} - {} with type {}",cgal_polygon[i]->id(), cgal_polygon[i+1]->id(), type );
+        chain_edges[{cgal_polygon[i],cgal_polygon[i+1]}] = type;
+        ++num_edges_inserted;
+    }
+}
+
+template<typename CDT>
+int edge_type( typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Chain_edges<CDT> &chain_edges ) {
+    auto known_edge = chain_edges.find({a,b});
+    if( known_edge!=chain_edges.end() ) return known_edge->second;
+    // tuple might be the other way around: check that too if we didn't find yet
+    known_edge = chain_edges.find({b,a});
+    if( known_edge!=chain_edges.end() ) return known_edge->second;
+    return 3; // we didn't add it, so it's a mesh edge. well, or a subdivided edge :(
+}
+
+template<typename CDT>
+int find_edge_type_bruteforce( typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Chain_edges<CDT> &chain_edges, std::size_t *num_tests ) {
+    typedef typename CDT::Point   Point;
+    typedef typename CDT::Segment Segment;
+    Segment needle{ a->point(), b->point() };
+    for (auto &hay : chain_edges) {
+        Point p1 = get<0>(hay.first)->point();
+        Point p2 = get<1>(hay.first)->point();
+        Segment seg{ p1, p2 };
+
+        if( num_tests ) ++*num_tests;
+        auto result = intersection(needle, seg);
+        if (result) {
+            // There is an intersection, but is it a segment or a point?
+            if( boost::get<Segment>(&*result) ) {
+                // The intersection is a segment! Return the type of the overlapping segment.
+                return hay.second;
+            }
+        }
+
+    }
+    // does not overlap any original edges
+    return -1;
+}
+
+template<typename CDT>
+int find_edge_type_hierarchy( CDT &cdt, typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Constraint_types<CDT> &constraint_types ) {
+    // not part of any input constraint? then it's a mesh edge
+    if( !cdt.is_subconstraint(a,b) ) return -1;
+    // otherwise ask the constraint hierarchy which input constraints it came from;
+    // if it lies on several, the lowest type wins (boundary, then hole, then road)
+    // (seams are not input constraints)
+    int type = -1;
+    for( auto ci = cdt.contexts_begin(a,b); ci!=cdt.contexts_end(a,b); ++ci ) {
+        typename CDT::Context context = *ci;
+        auto known = constraint_types.find(context.id());
+        if( known==constraint_types.end() || known->second==seam_type ) continue;
+        if( type==-1 || known->second<type ) type = known->second;
+    }
+    return type;
+}
+
+template<typename CDT>
+bool is_seam( CDT &cdt, typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Constraint_types<CDT> &constraint_types ) {
+    if( !cdt.is_subconstraint(a,b) ) return false;
+    for( auto ci = cdt.contexts_begin(a,b); ci!=cdt.contexts_end(a,b); ++ci ) {
+        typename CDT::Context context = *ci;
+        auto known = constraint_types.find(context.id());
+        if( known!=constraint_types.end() && known->second==seam_type ) return true;
+    }
+    return false;
+}
+
+// A boundary or hole segment counts once, whatever else runs along it
+inline bool is_wall_type( int type ) { return type==0 || type==1; }
+
+template<typename CDT>
+void add_duplicate( CDT &cdt, typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, int type, Constraint_types<CDT> &constraint_types, Wall_counts<CDT> &walls ) {
+    // The hierarchy does not take the same segment twice, so find the input
+    // constraint from a to b: it starts with a constrained edge from a towards b
+    // (the whole segment, or its first piece when something split it)
+    typedef typename CDT::Vertex_handle Vertex_handle;
+    auto ec = cdt.incident_edges(a), done = ec;
+    if( ec==nullptr ) return;
+    do {
+        if( !cdt.is_constrained(*ec) ) continue;
+        typename CDT::Face_handle f = ec->first;
+        int i = ec->second;
+        Vertex_handle w = f->vertex(f->cw(i))==a ? f->vertex(f->ccw(i)) : f->vertex(f->cw(i));
+        if( w!=b && !(CGAL::collinear(a->point(), w->point(), b->point())
+                      && CGAL::collinear_are_ordered_along_line(a->point(), w->point(), b->point())) ) continue;
+        for( auto ci = cdt.contexts_begin(a,w); ci!=cdt.contexts_end(a,w); ++ci ) {
+            typename CDT::Context context = *ci;
+            typename CDT::Constraint_id cid = context.id();
+            Vertex_handle first = *cdt.vertices_in_constraint_begin(cid);
+            Vertex_handle last = *std::prev(cdt.vertices_in_constraint_end(cid));
+            if( !((first==a && last==b) || (first==b && last==a)) ) continue;
+            auto known = constraint_types.find(cid);
+            if( known==constraint_types.end() || known->second==seam_type ) return;
+            auto count = walls.find(cid);
+            int n = count!=walls.end() ? count->second : is_wall_type(known->second);
+            walls[cid] = n + is_wall_type(type);
+            // lowest type wins, as for constraints that overlap in part
+            known->second = std::min( known->second, type );
+            return;
+        }
+    } while( ++ec!=done );
+    console->warn("Lost the type of a duplicate segment {} - {}", a->id(), b->id());
+}
+
+template<typename CDT>
+int count_walls( CDT &cdt, typename CDT::Vertex_handle a, typename CDT::Vertex_handle b, const Constraint_types<CDT> &constraint_types, const Wall_counts<CDT> &walls ) {
+    // boundary and hole segments along a-b, duplicates included
+    if( !cdt.is_subconstraint(a,b) ) return 0;
+    int n = 0;
+    for( auto ci = cdt.contexts_begin(a,b); ci!=cdt.contexts_end(a,b); ++ci ) {
+        typename CDT::Context context = *ci;
+        auto known = constraint_types.find(context.id());
+        if( known==constraint_types.end() || known->second==seam_type ) continue;
+        auto count = walls.find(context.id());
+        n += count!=walls.end() ? count->second : is_wall_type(known->second);
+    }
+    return n;
+}
+
+template<typename CDT>
+void label_edges( CDT &cdt, bool use_hierarchy, const Chain_edges<CDT> &chain_edges, const Constraint_types<CDT> &constraint_types ) {
+    // Done once the triangulation is final: inserting points destroys faces, and their tags with them
+    for( auto ei : cdt.finite_edges() ) {
+        typename CDT::Face_handle fh = ei.first;
+        int i = ei.second;
+        auto vh1 = fh->vertex(fh->cw(i));
+        auto vh2 = fh->vertex(fh->ccw(i));
+        int type = 3;
+        if( use_hierarchy ) {
+            // only constrained edges can be part of an input chain
+            if( fh->is_constrained(i) ) {
+                int original_type = find_edge_type_hierarchy(cdt, vh1, vh2, constraint_types);
+                if( original_type!=-1 ) type = original_type;
+            }
+        } else {
+            type = edge_type<CDT>(vh1,vh2,chain_edges);
+        }
+        // both faces see this edge
+        fh->set_edge_type(i,type);
+        fh->neighbor(i)->set_edge_type(cdt.mirror_index(fh,i),type);
+    }
+}
+
+// Run step (one step of a refinement algorithm; false when done) until done,
+// or until the budget runs out. The budget is shared, so whether the result
+// is partial is up to budget.exhausted() once all refinement is over.
+template<typename CDT, typename Step>
+void refine_within( CDT &cdt, Budget &budget, Step step ) {
+    size_t vertices = cdt.number_of_vertices();
+    while( budget.spend(cdt.number_of_vertices()-vertices) ) {
+        vertices = cdt.number_of_vertices();
+        if( !step() ) return;
+    }
+}
+
+// === Incremental re-meshing; see tessa.h
+
+struct Tessa_incremental::Impl {
+    virtual ~Impl() {}
+    virtual int update( const parser::TessaInput &input, Tessa_mesh &mesh ) = 0;
+    virtual void reset() = 0;
+    virtual void save( std::ostream &os ) const = 0;
+    virtual bool load( std::istream &is ) = 0;
+};
+
+template<typename K>
+class Incremental_impl : public Tessa_incremental::Impl {
+public:
+    typedef typename Tessa_triangulation<K>::CDT      CDT;
+    typedef typename Tessa_triangulation<K>::Criteria Criteria;
+    typedef typename CDT::Point                       Point;
+    typedef typename CDT::Vertex_handle               Vertex_handle;
+    typedef typename CDT::Face_handle                 Face_handle;
+    typedef typename CDT::Constraint_id               Constraint_id;
+    typedef typename K::FT                            FT;
+
+    explicit Incremental_impl( const Tessa_options &options ) : options(options) {}
+
+    int update( const parser::TessaInput &original_input, Tessa_mesh &mesh ) override {
+        parser::TessaInput prepared;
+        Tessa_stats prepare_stats;
+        const parser::TessaInput &input = prepare_input(original_input, options, prepared, prepare_stats);
+        if( !validate_input(input, options, prepare_stats) ) return tessa_invalid;
+        if( input.polygons.size()!=1 || input.polygons[0].empty() ) {
+            throw std::invalid_argument("incremental meshing takes exactly one polygon");
+        }
+        auto start_time = Clock::now();
+        const parser::Polygon &polygon = input.polygons[0];
+        if( built && same_points(polygon[0], outer) ) {
+            apply_changes(input);
+        } else {
+            console->info("Incremental: building from scratch");
+            rebuild(input);
+        }
+        auto change_time = Clock::now();
+
+        mark_domain( cdt, constraint_types, walls );
+        Criteria crit(options.meshing_param_B, options.meshing_param_S);
+        CGAL::Delaunay_mesher_2<CDT,Criteria> mesher(cdt, crit);
+        mesher.init(true); // domain is already initialized
+        Budget budget( options, cdt.number_of_vertices() );
+        if( budget.unlimited() ) mesher.refine_mesh();
+        else refine_within( cdt, budget, [&]() { return mesher.step_by_step_refine_mesh(); } );
+        label_edges( cdt, true, Chain_edges<CDT>(), constraint_types );
+        assign_ids();
+        auto mesh_time = Clock::now();
+
+        collect_vertices( cdt, mesh );
+        collect_domain_edges( cdt, mesh );
+        console->info("Incremental: changes in {} ms, meshing in {} ms; {} vertices",
+            std::chrono::duration<double,std::milli>(change_time-start_time).count(),
+            std::chrono::duration<double,std::milli>(mesh_time-change_time).count(),
+            cdt.number_of_vertices() );
+        if( budget.exhausted() ) {
+            // the next update goes on refining where this one stopped
+            console->warn("Refinement stopped early: out of budget; the result is valid and labeled, but does not meet the criteria everywhere");
+            return tessa_partial;
+        }
+        return 0;
+    }
+
+    void reset() override {
+        cdt.clear();
+        constraint_types.clear();
+        walls.clear();
+        owners.clear();
+        input_uses.clear();
+        chain_counts.clear();
+        outer.clear();
+        free_ids.clear();
+        next_id = 0;
+        built = false;
+    }
+
+    // Plain text. Coordinates of vertices are written exactly, so that
+    // refinement points on constraints are still on them after loading;
+    // with epick they are not exactly on them in the first place, and the
+    // constraints would not pass through them again, so load takes only
+    // snapshots made with epeck.
+    void save( std::ostream &os ) const override {
+        auto precision = os.precision(17);
+        os << "tessa_snapshot 1\n" << options.kernel << ' ' << options.meshing_param_B << ' ' << options.meshing_param_S << '\n';
+        os << "vertices " << cdt.number_of_vertices() << '\n';
+        for( auto vh : cdt.finite_vertex_handles() ) {
+            os << vh->id() << ' ';
+            write_coordinate( os, vh->point().x() );
+            os << ' ';
+            write_coordinate( os, vh->point().y() );
+            os << '\n';
+        }
+        os << "outer\n";
+        write_points( os, outer );
+        os << "chains " << chain_counts.size() << '\n';
+        for( auto &chain : chain_counts ) {
+            auto [type,points] = decode(chain.first);
+            os << type << ' ' << chain.second << '\n';
+            write_points( os, points );
+        }
+        os.precision(precision);
+    }
+
+    bool load( std::istream &is ) override {
+        reset();
+        try {
+            string word, kernel;
+            int version;
+            double B, S;
+            is >> word >> version >> kernel >> B >> S;
+            if( !is || word!="tessa_snapshot" || version!=1 ) return fail("not a snapshot");
+            if( options.kernel!="epeck" ) return fail("snapshots need --kernel=epeck");
+            if( kernel!=options.kernel || B!=options.meshing_param_B || S!=options.meshing_param_S ) {
+                return fail("snapshot was made with other parameters");
+            }
+            // The vertices, with their ids, in spatial sort order
+            size_t num_vertices;
+            is >> word >> num_vertices;
+            if( !is || word!="vertices" ) return fail("expected vertices");
+            vector<Point> points;
+            vector<int> ids;
+            for( size_t i=0; i<num_vertices; ++i ) {
+                int id;
+                FT x, y;
+                is >> id >> x >> y;
+                if( !is || id<0 ) return fail("bad vertex");
+                points.emplace_back(x, y);
+                ids.push_back(id);
+            }
+            vector<size_t> order(points.size());
+            for( size_t i=0; i<order.size(); ++i ) order[i] = i;
+            typedef CGAL::Spatial_sort_traits_adapter_2<K, typename CGAL::Pointer_property_map<Point>::type> Sort_traits;
+            CGAL::spatial_sort( order.begin(), order.end(), Sort_traits(CGAL::make_property_map(points)) );
+            Face_handle hint;
+            for( size_t i : order ) {
+                Vertex_handle vh = cdt.insert( points[i], hint );
+                hint = vh->face();
+                vh->id() = ids[i];
+                next_id = std::max(next_id, ids[i]+1);
+            }
+            if( static_cast<size_t>(next_id)!=cdt.number_of_vertices() ) return fail("vertex ids are not consecutive");
+
+            // And the chains, which find their vertices already there
+            is >> word;
+            if( !is || word!="outer" ) return fail("expected the outer ring");
+            outer = read_points(is);
+            add_chain( outer, 0 );
+            size_t num_chains;
+            is >> word >> num_chains;
+            if( !is || word!="chains" ) return fail("expected chains");
+            for( size_t c=0; c<num_chains; ++c ) {
+                int type, count;
+                is >> type >> count;
+                parser::Points chain = read_points(is);
+                if( !is || (type!=1 && type!=2) || count<1 ) return fail("bad chain");
+                for( int k=0; k<count; ++k ) add_chain( chain, type );
+                chain_counts[key_of(chain,type)] = count;
+            }
+            if( static_cast<size_t>(next_id)!=cdt.number_of_vertices() ) return fail("chains do not match the vertices");
+        } catch( std::exception &x ) {
+            return fail(x.what());
+        }
+        built = true;
+        return true;
+    }
+
+private:
+    // Every input segment, as a pair of vertices (smaller handle first), with
+    // the types of all chains that run along it. Only the first one inserts
+    // the constraint; the constraint goes when the last one goes.
+    typedef std::pair<Vertex_handle,Vertex_handle> Segment_key;
+    struct Segment_owners {
+        Constraint_id cid;
+        vector<int> types;
+    };
+
+    bool fail( const string &what ) {
+        console->warn("Cannot load snapshot: {}", what);
+        reset();
+        return false;
+    }
+
+    static bool same_points( const parser::Points &a, const parser::Points &b ) {
+        return a.size()==b.size() && std::equal( a.begin(), a.end(), b.begin(),
+            []( parser::Point p, parser::Point q ) { return p.x==q.x && p.y==q.y; } );
+    }
+
+    // A chain (hole or road) as a string: type, then the raw coordinates
+    static string key_of( const parser::Points &points, int type ) {
+        string key( 1+points.size()*sizeof(parser::Point), '\0' );
+        key[0] = static_cast<char>(type);
+        if( !points.empty() ) std::memcpy( &key[1], points.data(), points.size()*sizeof(parser::Point) );
+        return key;
+    }
+    static std::pair<int,parser::Points> decode( const string &key ) {
+        parser::Points points( (key.size()-1)/sizeof(parser::Point) );
+        if( !points.empty() ) std::memcpy( points.data(), &key[1], points.size()*sizeof(parser::Point) );
+        return { key[0], points };
+    }
+
+    static void write_coordinate( std::ostream &os, const FT &x ) {
+        if constexpr( std::is_same_v<FT,double> ) os << x;
+        else os << x.exact();
+    }
+    static void write_points( std::ostream &os, const parser::Points &points ) {
+        os << points.size() << '\n';
+        for( parser::Point p : points ) os << p.x << ' ' << p.y << '\n';
+    }
+    static parser::Points read_points( std::istream &is ) {
+        size_t n = 0;
+        is >> n;
+        parser::Points points;
+        for( size_t i=0; i<n && is; ++i ) {
+            parser::Point p;
+            is >> p.x >> p.y;
+            points.push_back(p);
+        }
+        return points;
+    }
+
+    void rebuild( const parser::TessaInput &input ) {
+        reset();
+        const parser::Polygon &polygon = input.polygons[0];
+        outer = polygon[0];
+        // ids in input order, like a normal run
+        auto give_ids = [&]( const vector<Vertex_handle> &vertices ) {
+            for( auto vh : vertices ) {
+                if( vh->id()==-1 ) vh->id() = next_id++;
+            }
+        };
+        give_ids( add_chain(outer, 0) );
+        for( size_t i=1; i<polygon.size(); ++i ) {
+            give_ids( add_chain(polygon[i], 1) );
+            ++chain_counts[key_of(polygon[i], 1)];
+        }
+        for( auto &linestring : input.linestrings ) {
+            give_ids( add_chain(linestring, 2) );
+            ++chain_counts[key_of(linestring, 2)];
+        }
+        built = true;
+    }
+
+    void apply_changes( const parser::TessaInput &input ) {
+        const parser::Polygon &polygon = input.polygons[0];
+        std::unordered_map<string,int> wanted;
+        for( size_t i=1; i<polygon.size(); ++i ) ++wanted[key_of(polygon[i], 1)];
+        for( auto &linestring : input.linestrings ) ++wanted[key_of(linestring, 2)];
+
+        vector<const string*> removed, added;
+        for( auto &chain : chain_counts ) {
+            auto w = wanted.find(chain.first);
+            for( int k = w==wanted.end() ? 0 : w->second; k<chain.second; ++k ) removed.push_back(&chain.first);
+        }
+        for( auto &chain : wanted ) {
+            auto c = chain_counts.find(chain.first);
+            for( int k = c==chain_counts.end() ? 0 : c->second; k<chain.second; ++k ) added.push_back(&chain.first);
+        }
+        console->info("Incremental: {} chains removed, {} added", removed.size(), added.size());
+        for( auto key : removed ) {
+            auto [type,points] = decode(*key);
+            remove_chain( points, type );
+        }
+        for( auto key : added ) {
+            auto [type,points] = decode(*key);
+            add_chain( points, type );
+        }
+        chain_counts.swap(wanted);
+    }
+
+    vector<Vertex_handle> add_chain( const parser::Points &points, int type ) {
+        vector<Vertex_handle> vertices;
+        vertices.reserve(points.size());
+        Face_handle hint;
+        for( parser::Point p : points ) {
+            Vertex_handle vh = cdt.insert( Point(p.x, p.y), hint );
+            hint = vh->face();
+            ++input_uses[vh];
+            if( !vertices.empty() && vertices.back()!=vh ) add_segment( vertices.back(), vh, type );
+            vertices.push_back(vh);
+        }
+        return vertices;
+    }
+
+    void add_segment( Vertex_handle a, Vertex_handle b, int type ) {
+        Segment_key key = a<b ? Segment_key(a,b) : Segment_key(b,a);
+        auto known = owners.find(key);
+        if( known==owners.end() ) {
+            Constraint_id cid = cdt.insert_constraint(a, b);
+            known = owners.emplace( key, Segment_owners{cid, {}} ).first;
+        }
+        known->second.types.push_back(type);
+        retype( known->second );
+    }
+
+    // Of all chains along a segment, the lowest type wins, like in a normal run;
+    // boundary and hole segments all count for the domain
+    void retype( const Segment_owners &owner ) {
+        if( owner.cid==Constraint_id(nullptr) ) return;
+        int type = *std::min_element( owner.types.begin(), owner.types.end() );
+        constraint_types[owner.cid] = type;
+        int n = static_cast<int>( std::count_if( owner.types.begin(), owner.types.end(), is_wall_type ) );
+        if( n!=is_wall_type(type) ) walls[owner.cid] = n;
+        else walls.erase(owner.cid);
+    }
+
+    Vertex_handle find_vertex( parser::Point p, Face_handle &hint ) {
+        typename CDT::Locate_type lt;
+        int li;
+        Face_handle f = cdt.locate( Point(p.x, p.y), lt, li, hint );
+        if( lt!=CDT::VERTEX ) throw std::logic_error("lost a vertex of a chain");
+        hint = f;
+        return f->vertex(li);
+    }
+
+    void remove_chain( const parser::Points &points, int type ) {
+        vector<Vertex_handle> vertices;
+        Face_handle hint;
+        for( parser::Point p : points ) vertices.push_back( find_vertex(p, hint) );
+
+        // Refinement points around the chain are there because of it; collect
+        // the ones near enough, walking out from the vertices along the chain
+        double longest = 0;
+        CGAL::Bbox_2 box;
+        for( size_t i=0; i<points.size(); ++i ) {
+            box += CGAL::Bbox_2( points[i].x, points[i].y, points[i].x, points[i].y );
+            if( i>0 ) longest = std::max( longest, std::hypot(points[i].x-points[i-1].x, points[i].y-points[i-1].y) );
+        }
+        box = CGAL::Bbox_2( box.xmin()-longest, box.ymin()-longest, box.xmax()+longest, box.ymax()+longest );
+        std::set<Vertex_handle> nearby;
+        vector<Vertex_handle> stack;
+        auto visit = [&]( Vertex_handle vh ) {
+            if( cdt.is_infinite(vh) || !CGAL::do_overlap(box, vh->point().bbox()) ) return;
+            if( nearby.insert(vh).second ) stack.push_back(vh);
+        };
+        for( size_t i=0; i+1<vertices.size(); ++i ) {
+            if( vertices[i]==vertices[i+1] ) continue;
+            Segment_key key = vertices[i]<vertices[i+1] ? Segment_key(vertices[i],vertices[i+1]) : Segment_key(vertices[i+1],vertices[i]);
+            auto known = owners.find(key);
+            if( known==owners.end() || known->second.cid==Constraint_id(nullptr) ) continue;
+            for( auto vi = cdt.vertices_in_constraint_begin(known->second.cid); vi!=cdt.vertices_in_constraint_end(known->second.cid); ++vi ) visit(*vi);
+        }
+        while( !stack.empty() ) {
+            Vertex_handle vh = stack.back();
+            stack.pop_back();
+            auto vc = cdt.incident_vertices(vh), done = vc;
+            if( vc!=nullptr ) {
+                do { visit(vc); } while( ++vc!=done );
+            }
+        }
+
+        // Drop the segments
+        for( size_t i=0; i+1<vertices.size(); ++i ) {
+            if( vertices[i]==vertices[i+1] ) continue;
+            Segment_key key = vertices[i]<vertices[i+1] ? Segment_key(vertices[i],vertices[i+1]) : Segment_key(vertices[i+1],vertices[i]);
+            auto known = owners.find(key);
+            if( known==owners.end() ) throw std::logic_error("lost a segment of a chain");
+            auto &types = known->second.types;
+            types.erase( std::find(types.begin(), types.end(), type) );
+            if( types.empty() ) {
+                if( known->second.cid!=Constraint_id(nullptr) ) {
+                    constraint_types.erase(known->second.cid);
+                    walls.erase(known->second.cid);
+                    cdt.remove_constraint(known->second.cid);
+                }
+                owners.erase(known);
+            } else {
+                retype(known->second);
+            }
+        }
+        for( auto vh : vertices ) {
+            auto uses = input_uses.find(vh);
+            if( uses!=input_uses.end() && --uses->second==0 ) input_uses.erase(uses);
+        }
+
+        // And the vertices that no constraint and no other chain holds on to
+        size_t num_removed = 0;
+        for( auto vh : nearby ) {
+            if( input_uses.count(vh) || cdt.are_there_incident_constraints(vh) ) continue;
+            free_ids.push_back( vh->id() );
+            cdt.remove(vh);
+            ++num_removed;
+        }
+        console->info("Incremental: removed a chain of {} points and {} vertices around it", points.size(), num_removed);
+    }
+
+    // New vertices take the ids of removed ones first. If there are fewer new
+    // ones, the vertices with the highest ids fill the gaps, so that ids stay
+    // consecutive from 0.
+    void assign_ids() {
+        for( auto vh : cdt.finite_vertex_handles() ) {
+            if( vh->id()!=-1 ) continue;
+            if( !free_ids.empty() ) {
+                vh->id() = free_ids.back();
+                free_ids.pop_back();
+            } else {
+                vh->id() = next_id++;
+            }
+        }
+        if( free_ids.empty() ) return;
+        vector<Vertex_handle> by_id( next_id );
+        for( auto vh : cdt.finite_vertex_handles() ) by_id[vh->id()] = vh;
+        int low = 0, high = next_id-1;
+        while( true ) {
+            while( low<high && by_id[low]!=Vertex_handle() ) ++low;
+            while( low<high && by_id[high]==Vertex_handle() ) --high;
+            if( low>=high ) break;
+            by_id[high]->id() = low;
+            std::swap( by_id[low], by_id[high] );
+        }
+        next_id = static_cast<int>(cdt.number_of_vertices());
+        free_ids.clear();
+    }
+
+    Tessa_options options;
+    bool built = false;
+    CDT cdt;
+    Constraint_types<CDT> constraint_types;
+    Wall_counts<CDT> walls;
+    std::map<Segment_key,Segment_owners> owners;
+    std::map<Vertex_handle,int> input_uses;               // number of chain points at each input vertex
+    std::unordered_map<string,int> chain_counts;          // holes and roads, by key_of
+    parser::Points outer;
+    vector<int> free_ids;                                 // ids of removed vertices
+    int next_id = 0;
+};
+
+Tessa_incremental::Tessa_incremental( const Tessa_options &options ) : opts(options) {
+    ensure_logger();
+    if( opts.kernel=="epick" ) impl = std::make_unique<Incremental_impl<Epick>>(opts);
+    else impl = std::make_unique<Incremental_impl<Epeck>>(opts);
+}
+
+Tessa_incremental::~Tessa_incremental() {}
+
+int Tessa_incremental::update( const parser::TessaInput &input, Tessa_mesh &mesh ) {
+    try {
+        return impl->update(input, mesh);
+    } catch( ... ) {
+        impl->reset();
+        throw;
+    }
+}
+
+void Tessa_incremental::save( std::ostream &os ) const { impl->save(os); }
+
+bool Tessa_incremental::load( std::istream &is ) { return impl->load(is); }
\ No newline at end of file
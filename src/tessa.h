@@ -0,0 +1,108 @@
+#ifndef INCLUDED_TESSA
+#define INCLUDED_TESSA
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+#include "stats.h"
+#include "tessa_input.h"
+#include "tessa_mesh.h"
+
+// === Tessa as a library ===
+// Everything the tessa executable does between parsing the input and writing
+// the output, without any I/O: give it polygons and roads, get a Tessa_mesh.
+// Link with tessa_lib. Logging goes to the spdlog logger "console" (see
+// logging.h); if there is none yet, one that writes errors to stderr is made.
+
+// Part of the key of cached results (see result_cache.h): change it when
+// the output for the same input and options changes
+const char *const tessa_version = "0.0.1";
+
+// Everything that affects what we do to the input
+struct Tessa_options {
+    bool make_cdt = false;
+    bool make_mesh = false;
+    bool make_gabriel = false;
+    double meshing_param_B = 0.125;
+    double meshing_param_S = 0;
+    std::string free_for;                   // only used by the writers; passed along for convenience
+    std::string reorder = "none";           // none, hilbert or morton; only used by the callers of reorder_mesh (reorder.h), like free_for
+    std::string repair_method = "hierarchy"; // hierarchy, indexed or bruteforce
+    std::string kernel = "epeck";            // epeck or epick
+    unsigned jobs = 1;                       // threads, for the polygons of a multipolygon or the tiles
+    int tiles = 1;                           // with make_mesh only: mesh in tiles x tiles pieces
+    std::size_t max_vertices = 0;            // stop refining at this many vertices; 0 means no limit
+    double time_limit = 0;                   // stop refining after this many seconds; 0 means no limit
+    double snap = 0;                         // merge input points closer than this first (see snap.h); 0 means not
+    double simplify = 0;                     // simplify the input with this tolerance first (see simplify.h); 0 means not
+    std::string validate = "off";            // off, warn or reject: look for crossing and unclosed rings first (see validate.h)
+    bool lean = false;                       // keep peak memory down, at a little extra time; edge lengths come from the double coordinates
+};
+
+// What tessellate returns when refinement stopped at max_vertices or
+// time_limit: the mesh is valid and labeled, but does not meet the meshing
+// criteria (or is not conforming) everywhere. Also the exit code of tessa.
+const int tessa_partial = 4;
+
+// What tessellate returns when validate is "reject" and the input has
+// crossing or unclosed rings, or when snapping left no polygon; the mesh
+// stays empty. Also the exit code of tessa.
+const int tessa_invalid = 5;
+
+// Tessellate the input into mesh, which should be empty. Returns 0,
+// tessa_partial or tessa_invalid. CGAL errors come out as exceptions. If stats is given, the times of the
+// stages and the counters are added to it.
+int tessellate( const parser::TessaInput &input, const Tessa_options &options, Tessa_mesh &mesh, Tessa_stats *stats = nullptr );
+
+// Input from flat arrays, for callers that do not have parser types at hand:
+// xy holds x0,y0,x1,y1,... for all chains one after the other, chain_sizes
+// the number of points in each chain. The first num_rings chains are the rings
+// of one polygon, outer ring first; the other chains are roads.
+parser::TessaInput make_input( const double *xy, const std::size_t *chain_sizes, std::size_t num_chains, std::size_t num_rings );
+
+// === Incremental re-meshing ===
+// Keeps the triangulation of one polygon between updates, for when the outer
+// boundary stays the same and only holes and roads change. An update removes
+// the constraints of the chains that are gone, together with the refinement
+// points around them, inserts the new chains, and refines again, which only
+// finds work near the changes. Vertices away from the changes keep their ids.
+// It saves rebuilding, not work per edit: marking the domain, labeling and
+// collecting the output still go over the whole mesh, so an update is
+// O(size of the mesh), with a much smaller constant than a new run.
+// The meshing parameters and kernel come from the options given here; only
+// meshing (make_mesh) is done. The state can be saved to and loaded from a
+// snapshot, with the epeck kernel only.
+
+class Tessa_incremental {
+public:
+    explicit Tessa_incremental( const Tessa_options &options );
+    ~Tessa_incremental();
+    Tessa_incremental( const Tessa_incremental& ) = delete;
+    Tessa_incremental &operator=( const Tessa_incremental& ) = delete;
+
+    const Tessa_options &options() const { return opts; }
+
+    // Bring the mesh up to date with input, which must have one polygon, and
+    // write the result to mesh (which should be empty). Starts from scratch
+    // on the first update, or if the outer ring changed. Returns 0,
+    // tessa_partial or tessa_invalid; after tessa_invalid, the state is as
+    // it was before the update.
+    // After an exception, the next update starts from scratch.
+    int update( const parser::TessaInput &input, Tessa_mesh &mesh );
+
+    void save( std::ostream &os ) const;
+    // False if the stream does not hold a snapshot made with the same kernel
+    // and meshing parameters, or if the kernel is not epeck; the next update
+    // then starts from scratch.
+    bool load( std::istream &is );
+
+    struct Impl;
+
+private:
+    Tessa_options opts;
+    std::unique_ptr<Impl> impl;
+};
+
+#endif //ndef INCLUDED_TESSA
\ No newline at end of file
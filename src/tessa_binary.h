@@ -0,0 +1,145 @@
+#ifndef INCLUDED_TESSA_BINARY
+#define INCLUDED_TESSA_BINARY
+
+// === Tessa binary mesh format ===
+// Written by `tessa --format=binary`. Everything is little-endian and every
+// section starts at a multiple of 8 bytes, so a consumer can mmap the file
+// and use the arrays in place. Only depends on the standard library; copy
+// this header into your own project to read tessa output.
+//
+// Layout (offsets are in the header, counted from the start of the file):
+//   header           Tessa_binary_header
+//   coordinates      double[2*num_vertices]      x and y of vertex i at 2i and 2i+1
+//   adjacency_begin  uint64[num_vertices+1]      CSR offsets into the arrays below
+//   targets          uint32[2*num_edges]         neighbouring vertex
+//   lengths          double[2*num_edges]         squared edge length (as in the text format)
+//   types            uint8[2*num_edges]          0 boundary, 1 hole, 2 road, 3 mesh
+//   free_for         uint32[2*num_edges]         index into the string table
+//   string_offsets   uint64[num_strings+1]       string i is chars[string_offsets[i], string_offsets[i+1])
+//   string_chars     char[...]
+// Every (undirected, bidirectional) edge appears twice: once in the
+// adjacency of each of its endpoints.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace tessa_binary {
+
+    constexpr char magic[8] = {'T','E','S','S','A','M','S','H'};
+    constexpr std::uint32_t version = 1;
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t header_size;
+        std::uint64_t file_size;
+        std::uint64_t num_vertices;
+        std::uint64_t num_edges;            // undirected; the adjacency has twice as many entries
+        std::uint64_t num_strings;
+        std::uint64_t coordinates_offset;
+        std::uint64_t adjacency_begin_offset;
+        std::uint64_t targets_offset;
+        std::uint64_t lengths_offset;
+        std::uint64_t types_offset;
+        std::uint64_t free_for_offset;
+        std::uint64_t string_offsets_offset;
+        std::uint64_t string_chars_offset;
+    };
+    static_assert( sizeof(Header)%8==0, "sections after the header must stay 8-byte aligned" );
+
+    inline bool host_is_little_endian() {
+        const std::uint16_t one = 1;
+        unsigned char first;
+        std::memcpy(&first, &one, 1);
+        return first==1;
+    }
+
+    inline std::uint64_t align8( std::uint64_t offset ) { return (offset+7) & ~std::uint64_t(7); }
+
+    // Read-only view on a tessa binary mesh that is already in memory
+    // (typically mmapped). Does not copy anything.
+    class Mesh_view {
+    public:
+        // Returns false if this does not look like a valid file we understand:
+        // wrong magic or version, or a section that is misaligned or does not
+        // fit in the file. The vertex and string indices in targets() and
+        // free_for() are not checked; tessa writes valid ones.
+        bool open( const void *data, std::size_t size ) {
+            base = static_cast<const unsigned char*>(data);
+            if( !host_is_little_endian() ) return false;
+            if( size<sizeof(Header) || reinterpret_cast<std::uintptr_t>(data)%8!=0 ) return false;
+            header = reinterpret_cast<const Header*>(data);
+            if( std::memcmp(header->magic, magic, sizeof(magic))!=0 ) return false;
+            if( header->version!=version || header->header_size!=sizeof(Header) ) return false;
+            if( header->file_size>size ) return false;
+
+            // Every section inside the file, and aligned for its type
+            const std::uint64_t n = header->num_vertices, m2 = 2*header->num_edges, s = header->num_strings;
+            if( n>max_count || header->num_edges>max_count || s>max_count ) return false;
+            if( !fits(header->coordinates_offset, 2*n, sizeof(double)) ||
+                !fits(header->adjacency_begin_offset, n+1, sizeof(std::uint64_t)) ||
+                !fits(header->targets_offset, m2, sizeof(std::uint32_t)) ||
+                !fits(header->lengths_offset, m2, sizeof(double)) ||
+                !fits(header->types_offset, m2, sizeof(std::uint8_t)) ||
+                !fits(header->free_for_offset, m2, sizeof(std::uint32_t)) ||
+                !fits(header->string_offsets_offset, s+1, sizeof(std::uint64_t)) ||
+                !fits(header->string_chars_offset, 0, sizeof(char)) ) return false;
+
+            // Offsets into the arrays must stay inside them
+            const std::uint64_t *begin = adjacency_begin();
+            if( begin[0]!=0 || begin[n]!=m2 ) return false;
+            for( std::uint64_t v=0; v<n; ++v ) if( begin[v]>begin[v+1] ) return false;
+            const std::uint64_t *offsets = section<std::uint64_t>(header->string_offsets_offset);
+            if( offsets[0]!=0 || offsets[s]>header->file_size-header->string_chars_offset ) return false;
+            for( std::uint64_t i=0; i<s; ++i ) if( offsets[i]>offsets[i+1] ) return false;
+            return true;
+        }
+
+        std::uint64_t num_vertices() const { return header->num_vertices; }
+        std::uint64_t num_edges() const { return header->num_edges; }
+        std::uint64_t num_strings() const { return header->num_strings; }
+
+        double x( std::uint64_t v ) const { return coordinates()[2*v]; }
+        double y( std::uint64_t v ) const { return coordinates()[2*v+1]; }
+
+        // Adjacency of v is [adjacency_begin()[v], adjacency_begin()[v+1])
+        // in targets(), lengths(), types() and free_for().
+        std::uint64_t degree( std::uint64_t v ) const { return adjacency_begin()[v+1]-adjacency_begin()[v]; }
+
+        const double        *coordinates()     const { return section<double>(header->coordinates_offset); }
+        const std::uint64_t *adjacency_begin() const { return section<std::uint64_t>(header->adjacency_begin_offset); }
+        const std::uint32_t *targets()         const { return section<std::uint32_t>(header->targets_offset); }
+        const double        *lengths()         const { return section<double>(header->lengths_offset); }
+        const std::uint8_t  *types()           const { return section<std::uint8_t>(header->types_offset); }
+        const std::uint32_t *free_for()        const { return section<std::uint32_t>(header->free_for_offset); }
+
+        std::string_view string( std::uint32_t i ) const {
+            const std::uint64_t *offsets = section<std::uint64_t>(header->string_offsets_offset);
+            const char *chars = section<char>(header->string_chars_offset);
+            return std::string_view( chars+offsets[i], offsets[i+1]-offsets[i] );
+        }
+
+    private:
+        // No count can be this large in a file that fits in memory; keeps
+        // the sizes below from overflowing
+        static constexpr std::uint64_t max_count = std::uint64_t(1)<<56;
+
+        // Does an array of count elements of size bytes at offset fit in
+        // the file, aligned to its element size (at most 8)?
+        bool fits( std::uint64_t offset, std::uint64_t count, std::uint64_t size ) const {
+            if( offset%size!=0 || offset<sizeof(Header) || offset>header->file_size ) return false;
+            return count*size<=header->file_size-offset;
+        }
+
+        template<typename T> const T *section( std::uint64_t offset ) const {
+            return reinterpret_cast<const T*>(base+offset);
+        }
+        const unsigned char *base = nullptr;
+        const Header *header = nullptr;
+    };
+
+}
+
+#endif //ndef INCLUDED_TESSA_BINARY
\ No newline at end of file
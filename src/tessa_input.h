@@ -0,0 +1,26 @@
+#ifndef INCLUDED_TESSA_INPUT
+#define INCLUDED_TESSA_INPUT
+
+#include <vector>
+
+// === What Tessa works on ===
+// One or more polygons (each a list of rings, outer ring first) and roads.
+// Rings are not closed implicitly: the last point should equal the first.
+
+namespace parser {
+    struct Point {
+        double x, y;
+    };
+    using Points = std::vector<Point>;
+    using Polygon = std::vector<Points>;
+    using LineString = Points;
+    using MultiPolygon = std::vector<Polygon>;
+    using MultiLineString = std::vector<LineString>;
+    //using TessaInput = std::tuple<Polygon,MultiLineString>;
+    struct TessaInput {
+        MultiPolygon polygons; // at least one
+        MultiLineString linestrings;
+    };
+}
+
+#endif //ndef INCLUDED_TESSA_INPUT
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef INCLUDED_TESSA_MESH
+#define INCLUDED_TESSA_MESH
+
+#include <cstddef>
+#include <vector>
+
+// === The result of tessellating, without any CGAL in it ===
+// Vertex i is the vertex with id i. Edge types are 0 (boundary), 1 (hole),
+// 2 (road) or 3 (mesh).
+
+struct Tessa_mesh {
+    std::vector<double> coordinates;        // x and y of vertex i at 2i and 2i+1
+    std::vector<int> edge_vertices;         // endpoints of edge j at 2j and 2j+1
+    std::vector<double> edge_lengths;       // squared length of each edge
+    std::vector<unsigned char> edge_types;  // type of each edge
+    std::size_t num_triangulation_edges = 0; // all finite edges, also outside the domain; the text header reports this
+
+    std::size_t num_vertices() const { return coordinates.size()/2; }
+    std::size_t num_edges() const { return edge_types.size(); }
+
+    void add_edge( int a, int b, double squared_length, int type ) {
+        edge_vertices.push_back(a);
+        edge_vertices.push_back(b);
+        edge_lengths.push_back(squared_length);
+        edge_types.push_back(static_cast<unsigned char>(type));
+    }
+
+    // Add another mesh after this one; its vertex ids shift by our number of vertices.
+    // With keep, only the vertices it marks come along, and no edge may use the others.
+    void append( const Tessa_mesh &other, const std::vector<bool> *keep = nullptr ) {
+        int offset = static_cast<int>(num_vertices());
+        edge_vertices.reserve( edge_vertices.size()+other.edge_vertices.size() );
+        if( keep ) {
+            std::vector<int> new_id( other.num_vertices(), -1 );
+            for( std::size_t v=0; v<other.num_vertices(); ++v ) {
+                if( !(*keep)[v] ) continue;
+                new_id[v] = static_cast<int>(num_vertices());
+                coordinates.push_back( other.coordinates[2*v] );
+                coordinates.push_back( other.coordinates[2*v+1] );
+            }
+            for( int v : other.edge_vertices ) edge_vertices.push_back(new_id[v]);
+        } else {
+            coordinates.insert( coordinates.end(), other.coordinates.begin(), other.coordinates.end() );
+            for( int v : other.edge_vertices ) edge_vertices.push_back(v+offset);
+        }
+        edge_lengths.insert( edge_lengths.end(), other.edge_lengths.begin(), other.edge_lengths.end() );
+        edge_types.insert( edge_types.end(), other.edge_types.begin(), other.edge_types.end() );
+        num_triangulation_edges += other.num_triangulation_edges;
+    }
+};
+
+#endif //ndef INCLUDED_TESSA_MESH
\ No newline at end of file
@@ -2,9 +2,13 @@
 #define INCLUDED_TESSA_TRIANGULATION
 
 
-//#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <map>
+#include <tuple>
+
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
+#include <CGAL/Constrained_triangulation_plus_2.h>
 #include <CGAL/Triangulation_vertex_base_with_id_2.h>
 #include <CGAL/Triangulation_conformer_2.h>
 #include <CGAL/lloyd_optimize_mesh_2.h>
@@ -13,8 +17,14 @@
 #include <CGAL/Delaunay_mesh_size_criteria_2.h>
 #include <CGAL/Polygon_2_algorithms.h>
 #include <CGAL/intersections.h>
+#include <CGAL/spatial_sort.h>
+#include <CGAL/Spatial_sort_traits_adapter_2.h>
+#include <CGAL/property_map.h>
 
-typedef CGAL::Exact_predicates_exact_constructions_kernel K;
+// Exact constructions are robust on degenerate input; inexact ones are much
+// faster and leaner. Everything below is parameterized on the kernel.
+typedef CGAL::Exact_predicates_exact_constructions_kernel   Epeck;
+typedef CGAL::Exact_predicates_inexact_constructions_kernel Epick;
 
 // === Our vertex ===
 
@@ -37,15 +47,67 @@ public:
     Tessa_vertex(Face_handle c) : Vb(c) {}
 };
 
+// === Our face ===
+// Remembers the type of each of its three edges (boundary, hole, road, mesh),
+// so the output does not have to look it up.
+
+template < typename GT,
+           typename Fb = CGAL::Delaunay_mesh_face_base_2<GT> >
+class Tessa_face : public Fb {
+public:
+    typedef typename Fb::Vertex_handle                 Vertex_handle;
+    typedef typename Fb::Face_handle                   Face_handle;
+    template < typename TDS2 >
+    struct Rebind_TDS {
+        typedef typename Fb::template Rebind_TDS<TDS2>::Other          Fb2;
+        typedef Tessa_face<GT, Fb2>     Other;
+    };
+    Tessa_face() : Fb() { clear_edge_types(); }
+    Tessa_face(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2)
+        : Fb(v0,v1,v2) { clear_edge_types(); }
+    Tessa_face(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2,
+               Face_handle n0, Face_handle n1, Face_handle n2)
+        : Fb(v0,v1,v2,n0,n1,n2) { clear_edge_types(); }
+    Tessa_face(Vertex_handle v0, Vertex_handle v1, Vertex_handle v2,
+               Face_handle n0, Face_handle n1, Face_handle n2,
+               bool c0, bool c1, bool c2)
+        : Fb(v0,v1,v2,n0,n1,n2,c0,c1,c2) { clear_edge_types(); }
+
+    int edge_type(int i) const { return types[i]; }
+    void set_edge_type(int i, int type) { types[i] = static_cast<unsigned char>(type); }
+
+    // scratch flag for traversals
+    bool is_visited() const { return visited; }
+    void set_visited(bool v) { visited = v; }
+
+private:
+    void clear_edge_types() { types[0] = types[1] = types[2] = 3; } // mesh, until told otherwise
+    unsigned char types[3];
+    bool visited = false;
+};
+
 // === Convenience typedefs
 
-typedef Tessa_vertex<K>                                     Tvb;
-typedef CGAL::Delaunay_mesh_face_base_2<K>                  Tfb;
-typedef CGAL::Triangulation_data_structure_2<Tvb, Tfb>      Tds;
-typedef CGAL::Constrained_Delaunay_triangulation_2<K,Tds>   CDT;
-typedef CGAL::Delaunay_mesh_size_criteria_2<CDT>            Criteria;
-typedef CDT::Point                                          Point;
-typedef CDT::Segment                                        Segment;
-typedef CDT::Vertex_handle                                  Vertex_handle;
+// Itag_ says what to do with crossing constraints; the default is CGAL's,
+// which refuses them. Tiles need Exact_predicates_tag, since tile borders
+// cross the input.
+template < typename K_, typename Itag_ = CGAL::Default >
+struct Tessa_triangulation {
+    typedef K_                                                  K;
+    typedef Tessa_vertex<K>                                     Tvb;
+    typedef Tessa_face<K>                                       Tfb;
+    typedef CGAL::Triangulation_data_structure_2<Tvb, Tfb>      Tds;
+    typedef CGAL::Constrained_Delaunay_triangulation_2<K,Tds,Itag_> CDT_base;
+    typedef CGAL::Constrained_triangulation_plus_2<CDT_base>    CDT; // keeps track of which input constraint each subconstraint came from
+    typedef CGAL::Delaunay_mesh_size_criteria_2<CDT>            Criteria;
+};
+
+// Bookkeeping of the input chains, for a given CDT
+template < typename CDT >
+using Chain_edges = std::map<std::tuple<typename CDT::Vertex_handle,typename CDT::Vertex_handle>,int>; // edge -> type
+template < typename CDT >
+using Constraint_types = std::map<typename CDT::Constraint_id,int>; // input constraint -> type
+template < typename CDT >
+using Wall_counts = std::map<typename CDT::Constraint_id,int>; // input constraint -> boundary and hole segments on it, where more than its own
 
 #endif //ndef INCLUDED_TESSA_TRIANGULATION
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef INCLUDED_TILES
+#define INCLUDED_TILES
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// === Tiled meshing ===
+// For --tiles, the bounding box of the input is cut into a grid of tiles.
+// Each tile is meshed in its own CDT, with the tile border inserted as extra
+// constraints of type seam_type, which the domain marking never crosses and
+// which never show up in the output (seam edges are mesh edges). The outer
+// border lies a little outside the input, so only the inner grid lines cut it.
+
+const int seam_type = 4;
+
+// Vertices are matched across tiles by their output coordinates
+typedef std::pair<double,double> Coordinates;
+struct Coordinates_hash {
+    std::size_t operator()( const Coordinates &c ) const {
+        double cx = c.first==0 ? 0.0 : c.first, cy = c.second==0 ? 0.0 : c.second; // -0 == 0
+        std::uint64_t x, y;
+        std::memcpy(&x, &cx, sizeof(x));
+        std::memcpy(&y, &cy, sizeof(y));
+        return std::hash<std::uint64_t>()( x ^ (y*0x9e3779b97f4a7c15ull) );
+    }
+};
+
+class Tile_grid {
+public:
+    Tile_grid( double xmin, double ymin, double xmax, double ymax, int n ) : n(std::max(1,n)) {
+        double margin = 0.01*std::max(xmax-xmin, ymax-ymin) + 1;
+        xs = lines( xmin-margin, xmax+margin );
+        ys = lines( ymin-margin, ymax+margin );
+    }
+
+    int size() const { return n*n; }
+    int tiles_per_side() const { return n; }
+
+    // Tile t covers [x0(t),x1(t)] x [y0(t),y1(t)]; tiles are numbered row by row
+    double x0( int t ) const { return xs[t%n]; }
+    double x1( int t ) const { return xs[t%n+1]; }
+    double y0( int t ) const { return ys[t/n]; }
+    double y1( int t ) const { return ys[t/n+1]; }
+    int tile( int column, int row ) const { return row*n+column; }
+
+    // First and last column (or row) whose closed range meets [lo,hi]
+    int first_column( double lo ) const { return first(xs, lo); }
+    int last_column( double hi ) const { return last(xs, hi); }
+    int first_row( double lo ) const { return first(ys, lo); }
+    int last_row( double hi ) const { return last(ys, hi); }
+
+private:
+    std::vector<double> lines( double lo, double hi ) const {
+        std::vector<double> v(n+1);
+        for( int i=0; i<=n; ++i ) v[i] = lo + (hi-lo)*i/n;
+        v[n] = hi;
+        return v;
+    }
+    int first( const std::vector<double> &v, double lo ) const {
+        // last line <= lo, so a point on a line belongs to the tiles on both sides
+        int i = static_cast<int>( std::upper_bound(v.begin(), v.end(), lo) - v.begin() ) - 1;
+        if( i>0 && v[i]==lo ) --i;
+        return std::clamp(i, 0, n-1);
+    }
+    int last( const std::vector<double> &v, double hi ) const {
+        int i = static_cast<int>( std::lower_bound(v.begin(), v.end(), hi) - v.begin() );
+        if( i<=n && v[i]==hi ) ++i;
+        return std::clamp(i-1, 0, n-1);
+    }
+
+    int n;
+    std::vector<double> xs, ys; // n+1 grid lines each
+};
+
+#endif //ndef INCLUDED_TILES
\ No newline at end of file
@@ -0,0 +1,261 @@
+#ifndef INCLUDED_VALIDATE
+#define INCLUDED_VALIDATE
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+
+#include "tessa_input.h"
+
+// === Validating the input (--validate) ===
+// Finds what makes the CDT silently compute intersection points, and later
+// stages go slow or wrong: rings that are not closed, rings that cross
+// themselves or each other, and roads that cross rings. Crossing means
+// that the insides of two segments meet in a point, that they overlap, that
+// a chain passes from one side of a segment to the other through a vertex
+// on its inside, or that two chains pass through a vertex they share and
+// cross each other there; touching at a point (a road ending on a ring, two
+// holes sharing a point) is fine, and so are roads crossing roads.
+// A sweep line runs over the segments sorted by their smallest x; every
+// segment is tested against the segments the line still crosses, if their
+// y ranges overlap. Sorting is O(n log n); the sweep is O(n k) for n
+// segments when the line crosses k of them at once. That k is small for
+// most input, but a few long segments (a large outer ring with long edges)
+// are in the way of everything, and then it is O(n^2). The predicates are
+// exact (CGAL's filtered Epick); the points reported are computed in doubles.
+// Shared vertices are found by sorting all vertices, O(n log n); at each,
+// every two chains through it are checked for crossing.
+
+namespace validate {
+
+    typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
+
+    struct Issue {
+        std::string what;   // for the log
+        parser::Point where;
+    };
+
+    // One ring or linestring of the input
+    struct Chain {
+        const parser::Points *points;
+        bool ring;
+        std::size_t polygon, index; // ring index within the polygon, or linestring index
+    };
+
+    inline std::string describe( const Chain &chain ) {
+        return chain.ring ? "ring " + std::to_string(chain.index) + " of polygon " + std::to_string(chain.polygon)
+                          : "linestring " + std::to_string(chain.index);
+    }
+
+    class Validator {
+    public:
+        Validator( const parser::TessaInput &input, std::size_t max_issues ) : max_issues(max_issues) {
+            for( std::size_t p=0; p<input.polygons.size(); ++p ) {
+                for( std::size_t r=0; r<input.polygons[p].size(); ++r ) chains.push_back({ &input.polygons[p][r], true, p, r });
+            }
+            for( std::size_t l=0; l<input.linestrings.size(); ++l ) chains.push_back({ &input.linestrings[l], false, 0, l });
+        }
+
+        std::vector<Issue> run() {
+            for( const Chain &chain : chains ) {
+                const parser::Points &points = *chain.points;
+                if( chain.ring && !points.empty() && !same(points.front(), points.back()) ) {
+                    report( describe(chain) + " is not closed", points.back() );
+                }
+            }
+
+            // Segments, without the zero-length ones, by smallest x
+            std::vector<Segment> segments;
+            for( std::size_t c=0; c<chains.size(); ++c ) {
+                const parser::Points &points = *chains[c].points;
+                for( std::size_t i=0; i+1<points.size(); ++i ) {
+                    if( !same(points[i], points[i+1]) ) segments.push_back( make_segment(c, i) );
+                }
+            }
+            std::sort( segments.begin(), segments.end(), []( const Segment &a, const Segment &b ) { return a.xmin<b.xmin; } );
+
+            std::vector<const Segment*> active;
+            for( const Segment &s : segments ) {
+                for( std::size_t k=0; k<active.size() && !full(); ) {
+                    const Segment &t = *active[k];
+                    if( t.xmax<s.xmin ) { // behind the sweep line for good
+                        active[k] = active.back();
+                        active.pop_back();
+                        continue;
+                    }
+                    if( t.ymin<=s.ymax && s.ymin<=t.ymax ) test(t, s);
+                    ++k;
+                }
+                if( full() ) break;
+                active.push_back(&s);
+            }
+            shared_vertices();
+            return issues;
+        }
+
+    private:
+        struct Segment {
+            std::size_t chain, i; // from point i to point i+1 of the chain
+            double xmin, xmax, ymin, ymax;
+        };
+
+        static bool same( parser::Point p, parser::Point q ) { return p.x==q.x && p.y==q.y; }
+        static K::Point_2 point( parser::Point p ) { return K::Point_2(p.x, p.y); }
+
+        Segment make_segment( std::size_t c, std::size_t i ) const {
+            parser::Point a = (*chains[c].points)[i], b = (*chains[c].points)[i+1];
+            return { c, i, std::min(a.x,b.x), std::max(a.x,b.x), std::min(a.y,b.y), std::max(a.y,b.y) };
+        }
+
+        bool full() const { return issues.size()>=max_issues; }
+
+        void report( std::string what, parser::Point where ) {
+            if( !full() ) issues.push_back({ std::move(what), where });
+        }
+
+        // Neighbours in a chain share a point, and that is all they may share
+        bool neighbours( const Segment &s, const Segment &t ) const {
+            if( s.chain!=t.chain ) return false;
+            std::size_t lo = std::min(s.i, t.i), hi = std::max(s.i, t.i);
+            const parser::Points &points = *chains[s.chain].points;
+            return hi==lo+1 || (chains[s.chain].ring && lo==0 && hi+2==points.size());
+        }
+
+        void test( const Segment &s, const Segment &t ) {
+            const Chain &cs = chains[s.chain], &ct = chains[t.chain];
+            if( !cs.ring && !ct.ring ) return; // roads may cross roads
+            if( neighbours(s, t) ) return;
+            parser::Point a = (*cs.points)[s.i], b = (*cs.points)[s.i+1];
+            parser::Point c = (*ct.points)[t.i], d = (*ct.points)[t.i+1];
+            auto o1 = CGAL::orientation(point(a), point(b), point(c)), o2 = CGAL::orientation(point(a), point(b), point(d));
+            auto o3 = CGAL::orientation(point(c), point(d), point(a)), o4 = CGAL::orientation(point(c), point(d), point(b));
+
+            auto kind = [&]() {
+                if( s.chain==t.chain ) return describe(cs) + " crosses itself";
+                return cs.ring ? describe(ct) + " crosses " + describe(cs) : describe(cs) + " crosses " + describe(ct);
+            };
+            if( o1!=CGAL::COLLINEAR && o2!=CGAL::COLLINEAR && o1!=o2 && o3!=CGAL::COLLINEAR && o4!=CGAL::COLLINEAR && o3!=o4 ) {
+                double denominator = (b.x-a.x)*(d.y-c.y) - (b.y-a.y)*(d.x-c.x);
+                double u = ((c.x-a.x)*(d.y-c.y) - (c.y-a.y)*(d.x-c.x))/denominator;
+                report( kind(), { a.x+u*(b.x-a.x), a.y+u*(b.y-a.y) } );
+            } else if( o1==CGAL::COLLINEAR && o2==CGAL::COLLINEAR ) {
+                // On one line: do they share more than a point? Compare along the longer axis.
+                bool along_x = std::abs(b.x-a.x)>=std::abs(b.y-a.y);
+                auto key = [along_x]( parser::Point p ) { return along_x ? p.x : p.y; };
+                double lo = std::max( std::min(key(a),key(b)), std::min(key(c),key(d)) );
+                double hi = std::min( std::max(key(a),key(b)), std::max(key(c),key(d)) );
+                if( lo<hi ) {
+                    parser::Point where = a;
+                    for( parser::Point p : { a, b, c, d } ) if( key(p)==lo ) where = p;
+                    report( kind() + " (overlapping)", where );
+                }
+            } else {
+                // A vertex on the inside of the other segment. Every vertex starts
+                // a segment, so checking starts sees each one once.
+                if( o1==CGAL::COLLINEAR && passes_through(a, b, t) ) report( kind() + " (through a vertex)", c );
+                if( o3==CGAL::COLLINEAR && passes_through(c, d, s) ) report( kind() + " (through a vertex)", a );
+            }
+        }
+
+        // A chain passing through one of its points, with the points before and after
+        struct Pass {
+            parser::Point at, before, after;
+            std::size_t chain;
+        };
+
+        void shared_vertices() {
+            std::vector<Pass> passes;
+            for( std::size_t c=0; c<chains.size(); ++c ) {
+                const parser::Points &points = *chains[c].points;
+                // the distinct points, in order; a closed ring goes around
+                std::vector<parser::Point> distinct;
+                for( parser::Point p : points ) {
+                    if( distinct.empty() || !same(distinct.back(), p) ) distinct.push_back(p);
+                }
+                bool around = chains[c].ring && distinct.size()>2 && same(distinct.front(), distinct.back());
+                if( around ) distinct.pop_back();
+                std::size_t n = distinct.size();
+                for( std::size_t i=0; i<n; ++i ) {
+                    if( !around && (i==0 || i+1==n) ) continue; // an end only touches
+                    passes.push_back({ distinct[i], distinct[(i+n-1)%n], distinct[(i+1)%n], c });
+                }
+            }
+            auto less = []( const Pass &a, const Pass &b ) { return a.at.x<b.at.x || (a.at.x==b.at.x && a.at.y<b.at.y); };
+            std::sort( passes.begin(), passes.end(), less );
+            for( std::size_t i=0; i<passes.size() && !full(); ) {
+                std::size_t j = i+1;
+                while( j<passes.size() && same(passes[j].at, passes[i].at) ) ++j;
+                for( std::size_t a=i; a<j; ++a ) {
+                    for( std::size_t b=a+1; b<j; ++b ) {
+                        const Chain &ca = chains[passes[a].chain], &cb = chains[passes[b].chain];
+                        if( !ca.ring && !cb.ring ) continue;
+                        if( side(passes[a], passes[b].before)*side(passes[a], passes[b].after)<0 ) {
+                            std::string what = passes[a].chain==passes[b].chain ? describe(ca) + " crosses itself"
+                                             : ca.ring ? describe(cb) + " crosses " + describe(ca) : describe(ca) + " crosses " + describe(cb);
+                            report( what + " (at a shared vertex)", passes[a].at );
+                        }
+                    }
+                }
+                i = j;
+            }
+        }
+
+        // Which side of the pass through v = pass.at is d on: 1 inside the angle
+        // turning counterclockwise from before to after, -1 outside, 0 on it
+        static int side( const Pass &pass, parser::Point d ) {
+            K::Point_2 v = point(pass.at), u = point(pass.before), w = point(pass.after), p = point(d);
+            auto on_ray = [&]( K::Point_2 r ) {
+                return CGAL::orientation(v, r, p)==CGAL::COLLINEAR && !CGAL::collinear_are_ordered_along_line(r, v, p);
+            };
+            if( on_ray(u) || on_ray(w) ) return 0;
+            switch( CGAL::orientation(v, u, w) ) {
+            case CGAL::LEFT_TURN:
+                return CGAL::orientation(v, u, p)==CGAL::LEFT_TURN && CGAL::orientation(v, p, w)==CGAL::LEFT_TURN ? 1 : -1;
+            case CGAL::RIGHT_TURN:
+                return CGAL::orientation(v, w, p)==CGAL::LEFT_TURN && CGAL::orientation(v, p, u)==CGAL::LEFT_TURN ? -1 : 1;
+            default:
+                if( !CGAL::collinear_are_ordered_along_line(u, v, w) ) return 0; // turns back on itself
+                return CGAL::orientation(v, u, p)==CGAL::LEFT_TURN ? 1 : -1;
+            }
+        }
+
+        // Does the chain of u cross the line from p to q at the start of u, when
+        // that lies on the line? Only if it is strictly between p and q, and the
+        // chain comes from one side and goes on to the other.
+        bool passes_through( parser::Point p, parser::Point q, const Segment &u ) const {
+            const Chain &chain = chains[u.chain];
+            const parser::Points &points = *chain.points;
+            parser::Point v = points[u.i];
+            if( !CGAL::collinear_are_strictly_ordered_along_line(point(p), point(v), point(q)) ) return false;
+            // The point before v, skipping repeats; a ring goes around
+            std::size_t j = u.i;
+            do {
+                if( j==0 ) {
+                    if( !chain.ring ) return false; // a road ending here only touches
+                    j = points.size();
+                }
+                --j;
+            } while( same(points[j], v) && j!=u.i );
+            if( same(points[j], v) ) return false;
+            auto before = CGAL::orientation(point(p), point(q), point(points[j]));
+            auto after = CGAL::orientation(point(p), point(q), point(points[u.i+1]));
+            return before!=CGAL::COLLINEAR && after!=CGAL::COLLINEAR && before!=after;
+        }
+
+        std::size_t max_issues;
+        std::vector<Chain> chains;
+        std::vector<Issue> issues;
+    };
+
+    // Up to max_issues problems with the input; none if it is fine
+    inline std::vector<Issue> validate( const parser::TessaInput &input, std::size_t max_issues = 100 ) {
+        return Validator(input, max_issues).run();
+    }
+
+}
+
+#endif //ndef INCLUDED_VALIDATE
\ No newline at end of file
@@ -0,0 +1,143 @@
+#ifndef INCLUDED_WRITE_MESH
+#define INCLUDED_WRITE_MESH
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "output_writer.h"
+#include "tessa_binary.h"
+#include "tessa_mesh.h"
+
+inline std::string_view type_name(int type) {
+    switch(type) {
+    case 0: return "boundary";
+    case 1: return "hole";
+    case 2: return "road";
+    case 3: return "mesh";
+    default: return "unknown";
+    }
+}
+
+// === Text format ===
+// Number of vertices, number of edges, then one line per vertex and one per edge;
+// fields separated by semicolons.
+
+inline void write_text( Output_writer &out, const Tessa_mesh &mesh, const std::string &free_for ) {
+    out.put( mesh.num_vertices() );
+    out.put( '\n' );
+    out.put( mesh.num_triangulation_edges );
+    out.put( '\n' );
+
+    // Output vertices
+    for( std::size_t i=0; i<mesh.num_vertices(); ++i ) {
+        out.put( i );
+        out.put( ';' );
+        out.put_fixed( mesh.coordinates[2*i] );
+        out.put( ';' );
+        out.put_fixed( mesh.coordinates[2*i+1] );
+        out.put( '\n' );
+    }
+
+    // Output edges
+    const char *bidirectional = "1";
+    for( std::size_t j=0; j<mesh.num_edges(); ++j ) {
+        out.put( mesh.edge_vertices[2*j] );
+        out.put( ';' );
+        out.put( mesh.edge_vertices[2*j+1] );
+        out.put( ';' );
+        out.put_fixed( mesh.edge_lengths[j] );
+        out.put( ';' );
+        out.put( free_for );
+        out.put( ';' );
+        out.put( bidirectional );
+        out.put( ';' );
+        out.put( type_name(mesh.edge_types[j]) );
+        out.put( ";\n" );
+    }
+    out.flush();
+}
+
+// === Binary format ===
+// See tessa_binary.h for the layout. Returns false if the host is big-endian.
+
+inline bool write_binary( std::ostream &os, const Tessa_mesh &mesh, const std::string &free_for ) {
+    using namespace tessa_binary;
+    if( !host_is_little_endian() ) return false;
+
+    const std::uint64_t n = mesh.num_vertices();
+    const std::uint64_t m = mesh.num_edges();
+
+    // Build the CSR adjacency: count degrees, prefix sums, then scatter both directions
+    std::vector<std::uint64_t> adjacency_begin(n+1, 0);
+    for( std::uint64_t j=0; j<m; ++j ) {
+        ++adjacency_begin[mesh.edge_vertices[2*j]+1];
+        ++adjacency_begin[mesh.edge_vertices[2*j+1]+1];
+    }
+    for( std::uint64_t v=0; v<n; ++v ) adjacency_begin[v+1] += adjacency_begin[v];
+    std::vector<std::uint64_t> fill( adjacency_begin.begin(), adjacency_begin.end()-1 );
+    std::vector<std::uint32_t> targets(2*m);
+    std::vector<double> lengths(2*m);
+    std::vector<std::uint8_t> types(2*m);
+    std::vector<std::uint32_t> free_for_index(2*m, 0); // all edges share the one string we have
+    auto add = [&]( std::uint64_t j, int from, int to ) {
+        std::uint64_t k = fill[from]++;
+        targets[k] = static_cast<std::uint32_t>(to);
+        lengths[k] = mesh.edge_lengths[j];
+        types[k] = mesh.edge_types[j];
+    };
+    for( std::uint64_t j=0; j<m; ++j ) {
+        add( j, mesh.edge_vertices[2*j], mesh.edge_vertices[2*j+1] );
+        add( j, mesh.edge_vertices[2*j+1], mesh.edge_vertices[2*j] );
+    }
+    std::vector<std::uint64_t> string_offsets{ 0, free_for.size() };
+
+    // Lay out the sections
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.header_size = sizeof(Header);
+    header.num_vertices = n;
+    header.num_edges = m;
+    header.num_strings = 1;
+    std::uint64_t offset = sizeof(Header);
+    auto place = [&]( std::uint64_t &section_offset, std::uint64_t bytes ) {
+        section_offset = offset;
+        offset = align8(offset+bytes);
+    };
+    place( header.coordinates_offset, mesh.coordinates.size()*sizeof(double) );
+    place( header.adjacency_begin_offset, adjacency_begin.size()*sizeof(std::uint64_t) );
+    place( header.targets_offset, targets.size()*sizeof(std::uint32_t) );
+    place( header.lengths_offset, lengths.size()*sizeof(double) );
+    place( header.types_offset, types.size()*sizeof(std::uint8_t) );
+    place( header.free_for_offset, free_for_index.size()*sizeof(std::uint32_t) );
+    place( header.string_offsets_offset, string_offsets.size()*sizeof(std::uint64_t) );
+    place( header.string_chars_offset, free_for.size() );
+    header.file_size = offset;
+
+    // And write them, padding each to the next multiple of 8
+    std::uint64_t written = 0;
+    auto write = [&]( const void *data, std::uint64_t bytes ) {
+        os.write( static_cast<const char*>(data), bytes );
+        written += bytes;
+        static const char zeros[8] = {};
+        os.write( zeros, align8(written)-written );
+        written = align8(written);
+    };
+    write( &header, sizeof(Header) );
+    write( mesh.coordinates.data(), mesh.coordinates.size()*sizeof(double) );
+    write( adjacency_begin.data(), adjacency_begin.size()*sizeof(std::uint64_t) );
+    write( targets.data(), targets.size()*sizeof(std::uint32_t) );
+    write( lengths.data(), lengths.size()*sizeof(double) );
+    write( types.data(), types.size()*sizeof(std::uint8_t) );
+    write( free_for_index.data(), free_for_index.size()*sizeof(std::uint32_t) );
+    write( string_offsets.data(), string_offsets.size()*sizeof(std::uint64_t) );
+    write( free_for.data(), free_for.size() );
+    os.flush();
+    return true;
+}
+
+#endif //ndef INCLUDED_WRITE_MESH
\ No newline at end of file
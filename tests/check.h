@@ -0,0 +1,23 @@
+#ifndef INCLUDED_CHECK
+#define INCLUDED_CHECK
+
+#include <cstdio>
+
+// === Minimal checks for the test programs ===
+// CHECK logs a failed condition and counts it; a test's main returns
+// failures(), so ctest sees a non-zero exit code.
+
+inline int &failures() {
+    static int count = 0;
+    return count;
+}
+
+#define CHECK(condition) \
+    do { \
+        if( !(condition) ) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures(); \
+        } \
+    } while( false )
+
+#endif //ndef INCLUDED_CHECK
@@ -0,0 +1,58 @@
+// Tiled meshing (--tiles) against the single run on the same input: every
+// edge has valid ids, no vertex is output without an edge unless it is an
+// input point, and the vertex and edge counts are close (the tiles refine
+// along their seams a little differently, so they are not equal).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "tessa.h"
+#include "check.h"
+
+static parser::TessaInput square_with_hole() {
+    parser::TessaInput input;
+    input.polygons.resize(1);
+    input.polygons[0].push_back({ {0,0}, {100,0}, {100,100}, {0,100}, {0,0} });
+    input.polygons[0].push_back({ {30,30}, {30,60}, {70,60}, {70,30}, {30,30} });
+    return input;
+}
+
+static void check_mesh( const Tessa_mesh &mesh, std::size_t input_points ) {
+    std::vector<bool> used( mesh.num_vertices(), false );
+    for( int v : mesh.edge_vertices ) {
+        CHECK( v>=0 && static_cast<std::size_t>(v)<mesh.num_vertices() );
+        if( v>=0 && static_cast<std::size_t>(v)<mesh.num_vertices() ) used[v] = true;
+    }
+    for( std::size_t v=input_points; v<mesh.num_vertices(); ++v ) CHECK( used[v] );
+}
+
+static bool similar( std::size_t a, std::size_t b ) {
+    return std::abs( double(a)-double(b) ) <= 0.2*std::max(a,b);
+}
+
+int main() {
+    const std::size_t input_points = 8; // distinct points of square_with_hole
+    for( std::string kernel : { "epeck", "epick" } ) {
+        Tessa_options options;
+        options.make_mesh = true;
+        options.meshing_param_S = 5;
+        options.kernel = kernel;
+        Tessa_mesh single;
+        CHECK( tessellate(square_with_hole(), options, single)==0 );
+        check_mesh( single, input_points );
+
+        options.tiles = 3;
+        options.jobs = 2;
+        Tessa_mesh tiled;
+        CHECK( tessellate(square_with_hole(), options, tiled)==0 );
+        check_mesh( tiled, input_points );
+        CHECK( similar(single.num_vertices(), tiled.num_vertices()) );
+        CHECK( similar(single.num_edges(), tiled.num_edges()) );
+        std::printf("%s: %zu vertices and %zu edges in one piece, %zu and %zu in tiles\n", kernel.c_str(),
+            single.num_vertices(), single.num_edges(), tiled.num_vertices(), tiled.num_edges());
+    }
+    return failures();
+}
@@ -0,0 +1,48 @@
+// Input validation: a road that touches a ring at one shared vertex and
+// crosses it at the next is reported once, at the crossing; holes that only
+// touch each other, or a road that ends on a ring, are fine.
+
+#include <string>
+#include <vector>
+
+#include "validate.h"
+#include "check.h"
+
+static parser::Polygon square_with_points_on_the_bottom() {
+    return { { {0,0}, {3,0}, {7,0}, {10,0}, {10,10}, {0,10}, {0,0} } };
+}
+
+int main() {
+    parser::TessaInput touch_then_cross;
+    touch_then_cross.polygons.push_back( square_with_points_on_the_bottom() );
+    touch_then_cross.linestrings.push_back({ {2,-2}, {3,0}, {4,-2}, {6,-2}, {7,0}, {8,2} });
+    auto issues = validate::validate(touch_then_cross);
+    CHECK( issues.size()==1 );
+    if( issues.size()==1 ) {
+        CHECK( issues[0].where.x==7 && issues[0].where.y==0 );
+        CHECK( issues[0].what=="linestring 0 crosses ring 0 of polygon 0 (at a shared vertex)" );
+    }
+
+    // Two holes touching at (5,5), from either side
+    parser::TessaInput touching_holes;
+    touching_holes.polygons.push_back( square_with_points_on_the_bottom() );
+    touching_holes.polygons[0].push_back({ {2,2}, {5,5}, {2,8}, {2,2} });
+    touching_holes.polygons[0].push_back({ {5,5}, {8,2}, {8,8}, {5,5} });
+    CHECK( validate::validate(touching_holes).empty() );
+
+    // The second hole passing through the first one's vertex instead
+    parser::TessaInput crossing_holes = touching_holes;
+    crossing_holes.polygons[0][2] = { {3,5}, {5,5}, {8,2}, {8,8}, {3,6}, {3,5} };
+    issues = validate::validate(crossing_holes);
+    bool at_vertex = false;
+    for( auto &issue : issues ) at_vertex = at_vertex || (issue.where.x==5 && issue.where.y==5);
+    CHECK( at_vertex );
+
+    // A road ending on the ring only touches it
+    parser::TessaInput road_end;
+    road_end.polygons.push_back( square_with_points_on_the_bottom() );
+    road_end.linestrings.push_back({ {3,0}, {5,5} });
+    CHECK( validate::validate(road_end).empty() );
+
+    return failures();
+}
@@ -0,0 +1,80 @@
+// The WKB reader: a valid polygon with a road parses; empty rings, rings of
+// fewer than three points, and empty linestrings do not.
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "logging.h"
+#include "parse_wkb.h"
+#include "check.h"
+
+// Little-endian WKB, written by hand
+class Wkb {
+public:
+    Wkb &header( std::uint32_t type ) { bytes += '\x01'; return word(type); }
+    Wkb &word( std::uint32_t w ) {
+        for( int i=0; i<4; ++i ) bytes += static_cast<char>( (w>>(8*i)) & 0xff );
+        return *this;
+    }
+    Wkb &points( std::initializer_list<std::pair<double,double>> list ) {
+        word( static_cast<std::uint32_t>(list.size()) );
+        for( auto p : list ) {
+            add(p.first);
+            add(p.second);
+        }
+        return *this;
+    }
+    std::string bytes;
+
+private:
+    void add( double d ) {
+        std::uint64_t w;
+        std::memcpy(&w, &d, sizeof(w));
+        for( int i=0; i<8; ++i ) bytes += static_cast<char>( (w>>(8*i)) & 0xff );
+    }
+};
+
+static bool parses( const Wkb &wkb ) {
+    return std::get<0>( parser::parse_wkb(wkb.bytes) );
+}
+
+int main() {
+    console = spdlog::stderr_color_mt("console");
+    console->set_level(spdlog::level::off);
+
+    // GEOMETRYCOLLECTION(POLYGON((0 0,1 0,1 1,0 0)),MULTILINESTRING((0 0,1 1)))
+    Wkb good;
+    good.header(7).word(2);
+    good.header(3).word(1).points({ {0,0}, {1,0}, {1,1}, {0,0} });
+    good.header(5).word(1);
+    good.header(2).points({ {0,0}, {1,1} });
+    CHECK( parses(good) );
+    auto [ok,input] = parser::parse_wkb(good.bytes);
+    CHECK( ok && input.polygons.size()==1 && input.polygons[0][0].size()==4 && input.linestrings.size()==1 );
+
+    Wkb empty_ring;
+    empty_ring.header(3).word(1).points({});
+    CHECK( !parses(empty_ring) );
+
+    Wkb short_ring;
+    short_ring.header(3).word(1).points({ {0,0}, {1,0} });
+    CHECK( !parses(short_ring) );
+
+    Wkb empty_hole;
+    empty_hole.header(3).word(2).points({ {0,0}, {1,0}, {1,1}, {0,0} }).points({});
+    CHECK( !parses(empty_hole) );
+
+    Wkb empty_linestring;
+    empty_linestring.header(7).word(2);
+    empty_linestring.header(3).word(1).points({ {0,0}, {1,0}, {1,1}, {0,0} });
+    empty_linestring.header(5).word(1);
+    empty_linestring.header(2).points({});
+    CHECK( !parses(empty_linestring) );
+
+    return failures();
+}